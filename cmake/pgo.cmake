@@ -0,0 +1,104 @@
+# Profile-guided optimization pipeline, run from a normal (LEARNGL_PGO=OFF)
+# build directory:
+#
+#   cmake --build build --target pgo
+#
+# runs these steps in order; each is also a target of its own:
+#
+#   pgo-generate  configures build/pgo with LEARNGL_PGO=GENERATE and builds it
+#   pgo-train     runs the instrumented bench over every scene (headless by
+#                 default) and, with Clang, merges the raw profiles
+#   pgo-use       reconfigures build/pgo with LEARNGL_PGO=USE and rebuilds it
+#   pgo-report    runs the bench of this build and of build/pgo and writes
+#                 build/pgo-report.md comparing their frame times
+#
+# Both phases use the same directory because GCC finds the profile of an
+# object by the object's path. The optimized examples end up in
+# build/pgo/bin/.
+
+set(LEARNGL_PGO_BUILD_DIR "${CMAKE_BINARY_DIR}/pgo")
+set(LEARNGL_PGO_PROFILES "${LEARNGL_PGO_BUILD_DIR}/profiles")
+set(LEARNGL_PGO_TRAIN_ARGS --headless --warmup=20 --frames=300 CACHE STRING "Arguments of the bench run that trains PGO")
+set(LEARNGL_PGO_REPORT_ARGS --headless --warmup=50 --frames=1000 CACHE STRING "Arguments of the bench runs compared by pgo-report")
+
+# The PGO build repeats this one's settings, so only PGO differs
+set(pgo_configure
+  "${CMAKE_COMMAND}" -S "${CMAKE_SOURCE_DIR}" -B "${LEARNGL_PGO_BUILD_DIR}"
+  -G "${CMAKE_GENERATOR}"
+  "-DCMAKE_BUILD_TYPE=${CMAKE_BUILD_TYPE}"
+  "-DCMAKE_C_COMPILER=${CMAKE_C_COMPILER}"
+  "-DCMAKE_CXX_COMPILER=${CMAKE_CXX_COMPILER}"
+  "-DCMAKE_PREFIX_PATH=${CMAKE_PREFIX_PATH}"
+  "-DGLAD_INCLUDE_DIR=${GLAD_INCLUDE_DIR}"
+  "-Dglfw3_DIR=${glfw3_DIR}"
+  "-DLEARNGL_LTO=${LEARNGL_LTO}"
+  "-DLEARNGL_NATIVE=${LEARNGL_NATIVE}"
+  "-DLEARNGL_TRACING=${LEARNGL_TRACING}"
+  "-DLEARNGL_PGO_DIR=${LEARNGL_PGO_PROFILES}"
+)
+if(GLM_INCLUDE_DIR)
+  list(APPEND pgo_configure "-DGLM_INCLUDE_DIR=${GLM_INCLUDE_DIR}")
+endif()
+
+set(pgo_bench_dir "${LEARNGL_PGO_BUILD_DIR}/bin/benchmarks")
+
+if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+  get_filename_component(compiler_dir "${CMAKE_CXX_COMPILER}" DIRECTORY)
+  find_program(LLVM_PROFDATA NAMES llvm-profdata HINTS "${compiler_dir}")
+  if(NOT LLVM_PROFDATA)
+    message(WARNING "llvm-profdata not found, the pgo targets will not work with Clang")
+  endif()
+  set(pgo_merge
+    COMMAND "${CMAKE_COMMAND}" "-DPROFDATA=${LLVM_PROFDATA}" "-DPROFILES=${LEARNGL_PGO_PROFILES}"
+            -P "${CMAKE_SOURCE_DIR}/cmake/pgo_merge.cmake"
+  )
+else()
+  set(pgo_merge)
+endif()
+
+add_custom_target(pgo-generate
+  COMMAND "${CMAKE_COMMAND}" -E rm -rf "${LEARNGL_PGO_PROFILES}"
+  COMMAND ${pgo_configure} -DLEARNGL_PGO=GENERATE
+  COMMAND "${CMAKE_COMMAND}" --build "${LEARNGL_PGO_BUILD_DIR}" --target bench
+  COMMENT "Building the instrumented bench"
+  VERBATIM
+)
+
+# Full path: a plain "bench" would name this build's bench target
+add_custom_target(pgo-train
+  COMMAND "${pgo_bench_dir}/bench" ${LEARNGL_PGO_TRAIN_ARGS} --output=training.json
+  ${pgo_merge}
+  WORKING_DIRECTORY "${pgo_bench_dir}"
+  COMMENT "Running the PGO training workload"
+  VERBATIM
+)
+
+add_custom_target(pgo-use
+  COMMAND ${pgo_configure} -DLEARNGL_PGO=USE
+  COMMAND "${CMAKE_COMMAND}" --build "${LEARNGL_PGO_BUILD_DIR}"
+  COMMENT "Rebuilding with the PGO profiles"
+  VERBATIM
+)
+
+add_custom_target(pgo-report
+  COMMAND "$<TARGET_FILE:bench>" ${LEARNGL_PGO_REPORT_ARGS} "--output=${CMAKE_BINARY_DIR}/pgo-baseline.json"
+  COMMAND "${pgo_bench_dir}/bench" ${LEARNGL_PGO_REPORT_ARGS} "--output=${CMAKE_BINARY_DIR}/pgo-optimized.json"
+  COMMAND "${CMAKE_COMMAND}"
+          "-DBASELINE=${CMAKE_BINARY_DIR}/pgo-baseline.json"
+          "-DOPTIMIZED=${CMAKE_BINARY_DIR}/pgo-optimized.json"
+          "-DOUTPUT=${CMAKE_BINARY_DIR}/pgo-report.md"
+          -P "${CMAKE_SOURCE_DIR}/cmake/pgo_report.cmake"
+  WORKING_DIRECTORY "${LEARNGL_BIN_DIR}/benchmarks"
+  COMMENT "Comparing frame times before and after PGO"
+  VERBATIM
+)
+add_dependencies(pgo-report bench)
+
+# The steps run one after the other, never in parallel
+add_custom_target(pgo
+  COMMAND "${CMAKE_COMMAND}" --build "${CMAKE_BINARY_DIR}" --target pgo-generate
+  COMMAND "${CMAKE_COMMAND}" --build "${CMAKE_BINARY_DIR}" --target pgo-train
+  COMMAND "${CMAKE_COMMAND}" --build "${CMAKE_BINARY_DIR}" --target pgo-use
+  COMMAND "${CMAKE_COMMAND}" --build "${CMAKE_BINARY_DIR}" --target pgo-report
+  VERBATIM
+)
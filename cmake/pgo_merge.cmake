@@ -0,0 +1,18 @@
+# Merges Clang's raw profiles into the file -fprofile-use reads.
+#
+#   cmake -DPROFDATA=llvm-profdata -DPROFILES=dir -P pgo_merge.cmake
+
+file(GLOB raw "${PROFILES}/*.profraw")
+
+if(NOT raw)
+  message(FATAL_ERROR "No .profraw files in ${PROFILES}, did the training run?")
+endif()
+
+execute_process(
+  COMMAND "${PROFDATA}" merge -o "${PROFILES}/default.profdata" ${raw}
+  RESULT_VARIABLE result
+)
+
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "llvm-profdata merge failed")
+endif()
@@ -0,0 +1,90 @@
+# Compares two bench JSON files, before and after PGO, as a Markdown table
+# of frame times per scene, printed and saved to OUTPUT.
+#
+#   cmake -DBASELINE=a.json -DOPTIMIZED=b.json -DOUTPUT=report.md -P pgo_report.cmake
+cmake_minimum_required(VERSION 3.19)
+
+# CMake only does integer math: times are handled in microseconds
+function(to_microseconds value out)
+  if(value MATCHES "e-")
+    set(${out} 0 PARENT_SCOPE)
+    return()
+  endif()
+
+  string(REGEX MATCH "^([0-9]*)\\.?([0-9]*)" _ "${value}")
+  set(whole "${CMAKE_MATCH_1}")
+  string(SUBSTRING "${CMAKE_MATCH_2}0000" 0 4 fraction)
+  if(whole STREQUAL "")
+    set(whole 0)
+  endif()
+
+  # Rounded: string(JSON) may print 3.3 as 3.2999999999999998
+  math(EXPR result "(${whole} * 10000 + ${fraction} + 5) / 10")
+  set(${out} ${result} PARENT_SCOPE)
+endfunction()
+
+function(format_milliseconds micro out)
+  math(EXPR whole "${micro} / 1000")
+  math(EXPR fraction "${micro} % 1000 + 1000")
+  string(SUBSTRING "${fraction}" 1 3 fraction)
+  set(${out} "${whole}.${fraction}" PARENT_SCOPE)
+endfunction()
+
+# Relative change with one decimal, e.g. -12.5%
+function(format_change before after out)
+  if(before EQUAL 0)
+    set(${out} "n/a" PARENT_SCOPE)
+    return()
+  endif()
+
+  math(EXPR permille "(${after} - ${before}) * 1000 / ${before}")
+  set(sign "+")
+  if(permille LESS 0)
+    set(sign "-")
+    math(EXPR permille "-(${permille})")
+  endif()
+
+  math(EXPR whole "${permille} / 10")
+  math(EXPR tenth "${permille} % 10")
+  set(${out} "${sign}${whole}.${tenth}%" PARENT_SCOPE)
+endfunction()
+
+file(READ "${BASELINE}" baseline)
+file(READ "${OPTIMIZED}" optimized)
+
+string(JSON renderer GET "${baseline}" renderer)
+string(JSON scene_count LENGTH "${baseline}" scenes)
+
+set(report "# PGO report\n\nRenderer: ${renderer}\n\n")
+string(APPEND report "Frame times in ms, before -> after PGO.\n\n")
+string(APPEND report "| Scene | CPU p50 | CPU p95 | CPU p99 | GPU p50 |\n")
+string(APPEND report "|-------|---------|---------|---------|---------|\n")
+
+math(EXPR last "${scene_count} - 1")
+foreach(i RANGE ${last})
+  string(JSON scene MEMBER "${baseline}" scenes ${i})
+  string(JSON missing ERROR_VARIABLE error GET "${optimized}" scenes ${scene})
+  if(error)
+    continue()
+  endif()
+
+  set(row "| ${scene} |")
+  foreach(metric cpu_ms:p50 cpu_ms:p95 cpu_ms:p99 gpu_ms:p50)
+    string(REPLACE ":" ";" path "${metric}")
+    string(JSON before GET "${baseline}" scenes ${scene} ${path})
+    string(JSON after GET "${optimized}" scenes ${scene} ${path})
+
+    to_microseconds("${before}" before)
+    to_microseconds("${after}" after)
+    format_milliseconds(${before} before_text)
+    format_milliseconds(${after} after_text)
+    format_change(${before} ${after} change)
+
+    string(APPEND row " ${before_text} -> ${after_text} (${change}) |")
+  endforeach()
+
+  string(APPEND report "${row}\n")
+endforeach()
+
+file(WRITE "${OUTPUT}" "${report}")
+message("${report}Report written to ${OUTPUT}")
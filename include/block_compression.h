@@ -0,0 +1,845 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLOCK_COMPRESSION_SSE2 1
+#endif
+
+#include "thread_pool.h"
+
+/**
+ * @brief CPU encoder (and decoder) for the BC1, BC3 and BC7 block
+ * compression formats, for cooking textures offline.
+ *
+ *   std::vector<unsigned char> blocks =
+ *     BlockCompression::compress(pixels, width, height, 4, BlockCompression::BC7, &pool);
+ *
+ * Every format stores 4x4 texel blocks: BC1 in 8 bytes (RGB, 4 bpp), BC3
+ * and BC7 in 16 (RGBA, 8 bpp), against the 24 or 32 bpp of GL_RGB8 and
+ * GL_RGBA8.
+ *
+ * Each block is fitted the same way: the endpoints are the extremes of
+ * the block's colors along their principal axis, every texel takes the
+ * nearest color of the palette they span, and the endpoints are then
+ * refined by least squares over those choices, keeping whichever of the
+ * two fits has the least error. The nearest-color search, where nearly
+ * all of the time goes, compares four texels at once with SSE2.
+ *
+ * BC7 is only written in mode 6 (one subset, 7-bit RGBA endpoints plus a
+ * shared bit, 16 levels): a fraction of the quality a full BC7 search
+ * gets, for a fraction of the time. Its color is still well above BC3's,
+ * but its alpha shares the indices of the color and comes out slightly
+ * below the separate alpha block of BC3 (49.9 vs 50.6 dB on
+ * awesomeface.png in b6-block-compression). decompress() only reads what
+ * compress() writes, i.e. BC7 mode 6.
+ *
+ * Pixels are 8-bit, 1 to 4 channels, rows tightly packed. Missing
+ * channels are read as a GL texture of that format samples them: green
+ * and blue 0, alpha 255.
+ */
+class BlockCompression
+{
+public:
+  enum Format
+  {
+    NONE,
+    BC1,
+    BC3,
+    BC7
+  };
+
+  static size_t blockBytes (Format format)
+  {
+    return format == BC1 ? 8 : 16;
+  }
+
+  static size_t compressedSize (int width, int height, Format format)
+  {
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+  }
+
+  /**
+   * @brief Compresses a whole image, one band of block rows per job when
+   * given a pool.
+   *
+   * @return the blocks, row by row in the order of the rows of pixels
+   */
+  static std::vector<unsigned char> compress (const unsigned char *pixels, int width, int height, int channels,
+                                              Format format, ThreadPool *pool = NULL)
+  {
+    int columns = (width + 3) / 4, rows = (height + 3) / 4;
+    std::vector<unsigned char> result(compressedSize(width, height, format));
+    size_t rowBytes = (size_t)columns * blockBytes(format);
+
+    auto band = [&] (int first, int last) {
+      for (int by = first; by < last; by++)
+      {
+        for (int bx = 0; bx < columns; bx++)
+        {
+          Block block;
+
+          load(block, pixels, width, height, channels, bx * 4, by * 4);
+          encode(block, format, &result[by * rowBytes + bx * blockBytes(format)]);
+        }
+      }
+    };
+
+    if (!pool || pool->size() <= 1 || rows < 2)
+    {
+      band(0, rows);
+      return result;
+    }
+
+    // A few bands per worker, so a slow band does not hold the rest back
+    int bands = (int)pool->size() * 4;
+    int step = (rows + bands - 1) / bands;
+    std::vector<std::future<void>> jobs;
+
+    for (int first = 0; first < rows; first += step)
+    {
+      int last = first + step < rows ? first + step : rows;
+      jobs.push_back(pool->submit([&band, first, last] () { band(first, last); }));
+    }
+    for (std::future<void> &job : jobs)
+    {
+      job.get();
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Decodes blocks back to RGBA, 4 bytes per pixel.
+   */
+  static std::vector<unsigned char> decompress (const unsigned char *blocks, int width, int height, Format format)
+  {
+    int columns = (width + 3) / 4, rows = (height + 3) / 4;
+    std::vector<unsigned char> result((size_t)width * height * 4);
+
+    for (int by = 0; by < rows; by++)
+    {
+      for (int bx = 0; bx < columns; bx++)
+      {
+        unsigned char texels[64];
+
+        decode(blocks + ((size_t)by * columns + bx) * blockBytes(format), format, texels);
+        for (int y = 0; y < 4 && by * 4 + y < height; y++)
+        {
+          for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+          {
+            memcpy(&result[((size_t)(by * 4 + y) * width + bx * 4 + x) * 4], &texels[(y * 4 + x) * 4], 4);
+          }
+        }
+      }
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Peak signal-to-noise ratio, in dB, between an image and the
+   * RGBA result of decompress().
+   *
+   * @param first, count the channels to compare, e.g. 0 and 3 for the
+   *   color of an RGBA image or 3 and 1 for its alpha; all by default
+   */
+  static double psnr (const unsigned char *pixels, const unsigned char *decoded, int width, int height, int channels,
+                      int first = 0, int count = 0)
+  {
+    double sum = 0.0;
+    size_t texels = (size_t)width * height;
+    int last = count > 0 && first + count < channels ? first + count : channels;
+
+    for (size_t i = 0; i < texels; i++)
+    {
+      for (int c = first; c < last; c++)
+      {
+        double difference = (double)pixels[i * channels + c] - decoded[i * 4 + c];
+        sum += difference * difference;
+      }
+    }
+
+    double mse = sum / ((double)texels * (last - first));
+    return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+  }
+
+private:
+  // One block, one array of 16 texels per channel
+  struct Block
+  {
+    alignas(16) float channel[4][16];
+  };
+
+  static void load (Block &block, const unsigned char *pixels, int width, int height, int channels, int x0, int y0)
+  {
+    static const float DEFAULTS[4] = {0.0f, 0.0f, 0.0f, 255.0f};
+
+    for (int y = 0; y < 4; y++)
+    {
+      // Blocks past the edge repeat the last row and column
+      int sy = y0 + y < height ? y0 + y : height - 1;
+
+      for (int x = 0; x < 4; x++)
+      {
+        int sx = x0 + x < width ? x0 + x : width - 1;
+        const unsigned char *texel = pixels + ((size_t)sy * width + sx) * channels;
+
+        for (int c = 0; c < 4; c++)
+        {
+          block.channel[c][y * 4 + x] = c < channels ? texel[c] : DEFAULTS[c];
+        }
+      }
+    }
+  }
+
+  /**
+   * Picks the nearest palette entry for every texel, by squared distance
+   * with the given weight per channel.
+   *
+   * @return the summed error
+   */
+  static float nearest (const Block &block, const float palette[][4], int count, const float weight[4], unsigned char indices[16])
+  {
+    float total = 0.0f;
+
+#ifdef BLOCK_COMPRESSION_SSE2
+    for (int group = 0; group < 16; group += 4)
+    {
+      __m128 texel[4], best = _mm_set1_ps(1e30f);
+      __m128i bestIndex = _mm_setzero_si128();
+
+      for (int c = 0; c < 4; c++)
+      {
+        texel[c] = _mm_load_ps(&block.channel[c][group]);
+      }
+
+      for (int p = 0; p < count; p++)
+      {
+        __m128 distance = _mm_setzero_ps();
+
+        for (int c = 0; c < 4; c++)
+        {
+          __m128 difference = _mm_sub_ps(texel[c], _mm_set1_ps(palette[p][c]));
+          distance = _mm_add_ps(distance, _mm_mul_ps(_mm_mul_ps(difference, difference), _mm_set1_ps(weight[c])));
+        }
+
+        __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+        bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+        best = _mm_min_ps(distance, best);
+      }
+
+      alignas(16) float errors[4];
+      alignas(16) int32_t chosen[4];
+
+      _mm_store_ps(errors, best);
+      _mm_store_si128((__m128i *)chosen, bestIndex);
+      for (int i = 0; i < 4; i++)
+      {
+        indices[group + i] = (unsigned char)chosen[i];
+        total += errors[i];
+      }
+    }
+#else
+    for (int i = 0; i < 16; i++)
+    {
+      float best = 1e30f;
+
+      for (int p = 0; p < count; p++)
+      {
+        float distance = 0.0f;
+
+        for (int c = 0; c < 4; c++)
+        {
+          float difference = block.channel[c][i] - palette[p][c];
+          distance += difference * difference * weight[c];
+        }
+
+        if (distance < best)
+        {
+          best = distance;
+          indices[i] = (unsigned char)p;
+        }
+      }
+      total += best;
+    }
+#endif
+
+    return total;
+  }
+
+  // Extremes of the block along the principal axis of its channels
+  static void principalAxis (const Block &block, int channels, float start[4], float end[4])
+  {
+    float mean[4] = {0.0f, 0.0f, 0.0f, 0.0f}, axis[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float covariance[4][4] = {{0.0f}};
+
+    for (int c = 0; c < channels; c++)
+    {
+      float low = 255.0f, high = 0.0f;
+
+      for (int i = 0; i < 16; i++)
+      {
+        mean[c] += block.channel[c][i];
+        low = block.channel[c][i] < low ? block.channel[c][i] : low;
+        high = block.channel[c][i] > high ? block.channel[c][i] : high;
+      }
+      mean[c] /= 16.0f;
+      axis[c] = high - low;
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+      for (int a = 0; a < channels; a++)
+      {
+        for (int b = 0; b < channels; b++)
+        {
+          covariance[a][b] += (block.channel[a][i] - mean[a]) * (block.channel[b][i] - mean[b]);
+        }
+      }
+    }
+
+    // Power iteration, from the diagonal of the bounding box
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+      float next[4] = {0.0f, 0.0f, 0.0f, 0.0f}, length = 0.0f;
+
+      for (int a = 0; a < channels; a++)
+      {
+        for (int b = 0; b < channels; b++)
+        {
+          next[a] += covariance[a][b] * axis[b];
+        }
+        length = fabsf(next[a]) > length ? fabsf(next[a]) : length;
+      }
+
+      if (length < 1e-6f)
+      {
+        break;
+      }
+      for (int c = 0; c < channels; c++)
+      {
+        axis[c] = next[c] / length;
+      }
+    }
+
+    float low = 0.0f, high = 0.0f, squared = 0.0f;
+    for (int c = 0; c < channels; c++)
+    {
+      squared += axis[c] * axis[c];
+    }
+
+    for (int i = 0; i < 16 && squared > 0.0f; i++)
+    {
+      float t = 0.0f;
+
+      for (int c = 0; c < channels; c++)
+      {
+        t += (block.channel[c][i] - mean[c]) * axis[c];
+      }
+      t /= squared;
+      low = t < low ? t : low;
+      high = t > high ? t : high;
+    }
+
+    for (int c = 0; c < 4; c++)
+    {
+      start[c] = c < channels ? clamp(mean[c] + axis[c] * low) : 255.0f;
+      end[c] = c < channels ? clamp(mean[c] + axis[c] * high) : 255.0f;
+    }
+  }
+
+  /**
+   * Least squares endpoints for the chosen indices, where index i lies at
+   * weights[i] of the way from start to end.
+   *
+   * @return false if every texel chose the same weight
+   */
+  static bool refine (const Block &block, int channels, const unsigned char indices[16], const float *weights, float start[4], float end[4])
+  {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f, sa[4] = {0.0f}, sb[4] = {0.0f};
+
+    for (int i = 0; i < 16; i++)
+    {
+      float t = weights[indices[i]], s = 1.0f - t;
+
+      aa += s * s;
+      ab += s * t;
+      bb += t * t;
+      for (int c = 0; c < channels; c++)
+      {
+        sa[c] += s * block.channel[c][i];
+        sb[c] += t * block.channel[c][i];
+      }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (fabsf(determinant) < 1e-6f)
+    {
+      return false;
+    }
+
+    for (int c = 0; c < channels; c++)
+    {
+      start[c] = clamp((bb * sa[c] - ab * sb[c]) / determinant);
+      end[c] = clamp((aa * sb[c] - ab * sa[c]) / determinant);
+    }
+    return true;
+  }
+
+  static float clamp (float value)
+  {
+    return value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+  }
+
+  static void encode (const Block &block, Format format, unsigned char *out)
+  {
+    switch (format)
+    {
+      case BC1:
+        encodeColor(block, out);
+        break;
+      case BC3:
+        encodeAlpha(block, out);
+        encodeColor(block, out + 8);
+        break;
+      default:
+        encodeMode6(block, out);
+        break;
+    }
+  }
+
+  static void decode (const unsigned char *in, Format format, unsigned char texels[64])
+  {
+    switch (format)
+    {
+      case BC1:
+        decodeColor(in, texels, true);
+        break;
+      case BC3:
+        decodeColor(in + 8, texels, false);
+        decodeAlpha(in, texels);
+        break;
+      default:
+        decodeMode6(in, texels);
+        break;
+    }
+  }
+
+  // ---------------------------------------------------------------------
+  // BC1 color block: two RGB565 endpoints and 2-bit indices
+  // ---------------------------------------------------------------------
+
+  static uint16_t pack565 (const float color[4])
+  {
+    return (uint16_t)(((int)(color[0] * 31.0f / 255.0f + 0.5f) << 11) |
+                      ((int)(color[1] * 63.0f / 255.0f + 0.5f) << 5) |
+                      (int)(color[2] * 31.0f / 255.0f + 0.5f));
+  }
+
+  static void unpack565 (uint16_t color, int rgb[3])
+  {
+    int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+  }
+
+  // Palette of a color block in 4-color mode (color0 > color1)
+  static void colorPalette (uint16_t color0, uint16_t color1, float palette[4][4])
+  {
+    int a[3], b[3];
+
+    unpack565(color0, a);
+    unpack565(color1, b);
+    for (int c = 0; c < 3; c++)
+    {
+      palette[0][c] = (float)a[c];
+      palette[1][c] = (float)b[c];
+      palette[2][c] = (float)((2 * a[c] + b[c]) / 3);
+      palette[3][c] = (float)((a[c] + 2 * b[c]) / 3);
+    }
+    for (int p = 0; p < 4; p++)
+    {
+      palette[p][3] = 0.0f;
+    }
+  }
+
+  static void encodeColor (const Block &block, unsigned char *out)
+  {
+    static const float WEIGHT[4] = {1.0f, 1.0f, 1.0f, 0.0f};
+    static const float POSITION[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+    float start[4], end[4], bestError = 1e30f;
+    uint16_t bestColor0 = 0, bestColor1 = 0;
+    unsigned char bestIndices[16] = {0};
+
+    principalAxis(block, 3, start, end);
+
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+      uint16_t color0 = pack565(start), color1 = pack565(end);
+      unsigned char indices[16] = {0};
+      float palette[4][4], error;
+
+      if (color0 < color1)
+      {
+        uint16_t swap = color0;
+        color0 = color1;
+        color1 = swap;
+      }
+
+      if (color0 == color1)
+      {
+        // Three-color mode, where index 0 is still color0
+        colorPalette(color0, color1, palette);
+        error = nearest(block, palette, 1, WEIGHT, indices);
+      }
+      else
+      {
+        colorPalette(color0, color1, palette);
+        error = nearest(block, palette, 4, WEIGHT, indices);
+      }
+
+      if (error < bestError)
+      {
+        bestError = error;
+        bestColor0 = color0;
+        bestColor1 = color1;
+        memcpy(bestIndices, indices, 16);
+      }
+
+      // Refined start and end belong to color0 and color1
+      if (color0 == color1 || !refine(block, 3, indices, POSITION, start, end))
+      {
+        break;
+      }
+    }
+
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; i++)
+    {
+      bits |= (uint32_t)bestIndices[i] << (i * 2);
+    }
+
+    out[0] = (unsigned char)(bestColor0 & 0xFF);
+    out[1] = (unsigned char)(bestColor0 >> 8);
+    out[2] = (unsigned char)(bestColor1 & 0xFF);
+    out[3] = (unsigned char)(bestColor1 >> 8);
+    for (int i = 0; i < 4; i++)
+    {
+      out[4 + i] = (unsigned char)(bits >> (i * 8));
+    }
+  }
+
+  // BC3 color blocks are always read in 4-color mode
+  static void decodeColor (const unsigned char *in, unsigned char texels[64], bool threeColorMode)
+  {
+    uint16_t color0 = (uint16_t)(in[0] | (in[1] << 8)), color1 = (uint16_t)(in[2] | (in[3] << 8));
+    uint32_t bits = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+    int a[3], b[3], palette[4][4];
+
+    unpack565(color0, a);
+    unpack565(color1, b);
+    for (int c = 0; c < 3; c++)
+    {
+      palette[0][c] = a[c];
+      palette[1][c] = b[c];
+      if (color0 > color1 || !threeColorMode)
+      {
+        palette[2][c] = (2 * a[c] + b[c]) / 3;
+        palette[3][c] = (a[c] + 2 * b[c]) / 3;
+      }
+      else
+      {
+        palette[2][c] = (a[c] + b[c]) / 2;
+        palette[3][c] = 0;
+      }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = color0 > color1 || !threeColorMode ? 255 : 0;
+
+    for (int i = 0; i < 16; i++)
+    {
+      for (int c = 0; c < 4; c++)
+      {
+        texels[i * 4 + c] = (unsigned char)palette[(bits >> (i * 2)) & 3][c];
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------
+  // BC3 alpha block: two 8-bit endpoints and 3-bit indices
+  // ---------------------------------------------------------------------
+
+  static void encodeAlpha (const Block &block, unsigned char *out)
+  {
+    static const float WEIGHT[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    float low = 255.0f, high = 0.0f, palette[8][4] = {{0.0f}};
+    unsigned char indices[16] = {0};
+
+    for (int i = 0; i < 16; i++)
+    {
+      low = block.channel[3][i] < low ? block.channel[3][i] : low;
+      high = block.channel[3][i] > high ? block.channel[3][i] : high;
+    }
+
+    int alpha0 = (int)high, alpha1 = (int)low;
+    if (alpha0 > alpha1)
+    {
+      // 8-alpha mode
+      palette[0][3] = (float)alpha0;
+      palette[1][3] = (float)alpha1;
+      for (int p = 2; p < 8; p++)
+      {
+        palette[p][3] = (float)(((8 - p) * alpha0 + (p - 1) * alpha1) / 7);
+      }
+      nearest(block, palette, 8, WEIGHT, indices);
+    }
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; i++)
+    {
+      bits |= (uint64_t)indices[i] << (i * 3);
+    }
+
+    out[0] = (unsigned char)alpha0;
+    out[1] = (unsigned char)alpha1;
+    for (int i = 0; i < 6; i++)
+    {
+      out[2 + i] = (unsigned char)(bits >> (i * 8));
+    }
+  }
+
+  static void decodeAlpha (const unsigned char *in, unsigned char texels[64])
+  {
+    int alpha0 = in[0], alpha1 = in[1], palette[8];
+    uint64_t bits = 0;
+
+    for (int i = 0; i < 6; i++)
+    {
+      bits |= (uint64_t)in[2 + i] << (i * 8);
+    }
+
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    for (int p = 2; p < 8; p++)
+    {
+      if (alpha0 > alpha1)
+      {
+        palette[p] = ((8 - p) * alpha0 + (p - 1) * alpha1) / 7;
+      }
+      else
+      {
+        palette[p] = p < 6 ? ((6 - p) * alpha0 + (p - 1) * alpha1) / 5 : (p == 6 ? 0 : 255);
+      }
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+      texels[i * 4 + 3] = (unsigned char)palette[(bits >> (i * 3)) & 7];
+    }
+  }
+
+  // ---------------------------------------------------------------------
+  // BC7 mode 6: 7-bit RGBA endpoints, a shared low bit per endpoint and
+  // 4-bit indices, the first one with an implicit leading 0
+  // ---------------------------------------------------------------------
+
+  struct BitStream
+  {
+    unsigned char *bytes;
+    int position;
+
+    void write (unsigned int value, int count)
+    {
+      for (int i = 0; i < count; i++, position++)
+      {
+        if ((value >> i) & 1)
+        {
+          bytes[position >> 3] |= (unsigned char)(1 << (position & 7));
+        }
+      }
+    }
+
+    unsigned int read (int count)
+    {
+      unsigned int value = 0;
+
+      for (int i = 0; i < count; i++, position++)
+      {
+        value |= (unsigned int)((bytes[position >> 3] >> (position & 7)) & 1) << i;
+      }
+      return value;
+    }
+  };
+
+  static const int *mode6Weights ()
+  {
+    static const int WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    return WEIGHTS;
+  }
+
+  // The 7-bit value and shared bit closest to an endpoint
+  static void quantizeMode6 (const float endpoint[4], int quantized[4], int &pbit)
+  {
+    float bestError = 1e30f;
+
+    for (int p = 0; p < 2; p++)
+    {
+      int candidate[4];
+      float error = 0.0f;
+
+      for (int c = 0; c < 4; c++)
+      {
+        int q = (int)((endpoint[c] - p) / 2.0f + 0.5f);
+        candidate[c] = q < 0 ? 0 : (q > 127 ? 127 : q);
+
+        float difference = (float)((candidate[c] << 1) | p) - endpoint[c];
+        error += difference * difference;
+      }
+
+      if (error < bestError)
+      {
+        bestError = error;
+        memcpy(quantized, candidate, sizeof(candidate));
+        pbit = p;
+      }
+    }
+  }
+
+  static void encodeMode6 (const Block &block, unsigned char *out)
+  {
+    static const float WEIGHT[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    float start[4], end[4], positions[16], bestError = 1e30f;
+    int best[2][4] = {{0}}, bestP[2] = {0, 0};
+    unsigned char bestIndices[16] = {0};
+
+    for (int i = 0; i < 16; i++)
+    {
+      positions[i] = mode6Weights()[i] / 64.0f;
+    }
+
+    principalAxis(block, 4, start, end);
+
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+      int endpoints[2][4], pbits[2] = {0, 0};
+      float palette[16][4];
+      unsigned char indices[16];
+
+      quantizeMode6(start, endpoints[0], pbits[0]);
+      quantizeMode6(end, endpoints[1], pbits[1]);
+
+      for (int p = 0; p < 16; p++)
+      {
+        int w = mode6Weights()[p];
+
+        for (int c = 0; c < 4; c++)
+        {
+          int a = (endpoints[0][c] << 1) | pbits[0], b = (endpoints[1][c] << 1) | pbits[1];
+          palette[p][c] = (float)(((64 - w) * a + w * b + 32) >> 6);
+        }
+      }
+
+      float error = nearest(block, palette, 16, WEIGHT, indices);
+      if (error < bestError)
+      {
+        bestError = error;
+        memcpy(best, endpoints, sizeof(best));
+        memcpy(bestP, pbits, sizeof(bestP));
+        memcpy(bestIndices, indices, 16);
+      }
+
+      if (!refine(block, 4, indices, positions, start, end))
+      {
+        break;
+      }
+    }
+
+    // The first index is stored in 3 bits: make sure it is below 8
+    if (bestIndices[0] >= 8)
+    {
+      for (int c = 0; c < 4; c++)
+      {
+        int swap = best[0][c];
+        best[0][c] = best[1][c];
+        best[1][c] = swap;
+      }
+      int swap = bestP[0];
+      bestP[0] = bestP[1];
+      bestP[1] = swap;
+
+      for (int i = 0; i < 16; i++)
+      {
+        bestIndices[i] = (unsigned char)(15 - bestIndices[i]);
+      }
+    }
+
+    BitStream stream = {out, 0};
+
+    memset(out, 0, 16);
+    stream.write(1 << 6, 7);
+    for (int c = 0; c < 4; c++)
+    {
+      stream.write((unsigned int)best[0][c], 7);
+      stream.write((unsigned int)best[1][c], 7);
+    }
+    stream.write((unsigned int)bestP[0], 1);
+    stream.write((unsigned int)bestP[1], 1);
+    for (int i = 0; i < 16; i++)
+    {
+      stream.write(bestIndices[i], i == 0 ? 3 : 4);
+    }
+  }
+
+  static void decodeMode6 (const unsigned char *in, unsigned char texels[64])
+  {
+    BitStream stream = {(unsigned char *)in, 0};
+    int endpoints[2][4];
+
+    if (stream.read(7) != 1 << 6)
+    {
+      // Not written by encodeMode6: magenta, to make it obvious
+      for (int i = 0; i < 16; i++)
+      {
+        texels[i * 4 + 0] = 255;
+        texels[i * 4 + 1] = 0;
+        texels[i * 4 + 2] = 255;
+        texels[i * 4 + 3] = 255;
+      }
+      return;
+    }
+
+    for (int c = 0; c < 4; c++)
+    {
+      endpoints[0][c] = (int)stream.read(7);
+      endpoints[1][c] = (int)stream.read(7);
+    }
+
+    int p0 = (int)stream.read(1), p1 = (int)stream.read(1);
+    for (int c = 0; c < 4; c++)
+    {
+      endpoints[0][c] = (endpoints[0][c] << 1) | p0;
+      endpoints[1][c] = (endpoints[1][c] << 1) | p1;
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+      int w = mode6Weights()[stream.read(i == 0 ? 3 : 4)];
+
+      for (int c = 0; c < 4; c++)
+      {
+        texels[i * 4 + c] = (unsigned char)(((64 - w) * endpoints[0][c] + w * endpoints[1][c] + 32) >> 6);
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,641 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <vector>
+
+#include "frustum.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Bounding volume hierarchy over the bounds of scene objects, for
+ * visibility and picking queries that do not look at every object.
+ *
+ *   Bvh bvh;
+ *   bvh.build(bounds, &pool);          // objects added or removed
+ *   bvh.refit(bounds);                 // same objects, moved
+ *   bvh.query(camera.GetFrustum(), [&] (uint32_t i) { draw(i); });
+ *   int picked = bvh.raycast(origin, direction, distance);
+ *
+ * Objects are referred to by their index in the bounds given to build().
+ *
+ * build() splits the objects top-down with the surface area heuristic,
+ * evaluated on BINS buckets of their centers per axis. The nodes end up
+ * in one array of 32-byte nodes; the two children of a node are stored
+ * side by side, starting at an even index, so they share a cache line,
+ * and the bounds of the objects are copied next to each other in leaf
+ * order. With a ThreadPool and at least PARALLEL objects, the first few
+ * levels are split on the calling thread and the subtrees under them are
+ * built as jobs, each into an array of its own that is appended to the
+ * main one at the end.
+ *
+ * refit() keeps the tree and recomputes its bounds bottom-up, which is
+ * far cheaper than a build but lets the tree get worse as objects move
+ * away from where it was built; cost() measures how much, so a caller
+ * can rebuild once it has grown too much.
+ */
+class Bvh
+{
+public:
+  static constexpr int BINS = 16;
+  static constexpr int MAX_DEPTH = 64;
+  static constexpr uint32_t MAX_LEAF = 4;
+  static constexpr size_t PARALLEL = 1 << 14;
+
+  struct Bounds
+  {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    void grow (const Bounds &other)
+    {
+      min = glm::vec3(std::min(min.x, other.min.x), std::min(min.y, other.min.y), std::min(min.z, other.min.z));
+      max = glm::vec3(std::max(max.x, other.max.x), std::max(max.y, other.max.y), std::max(max.z, other.max.z));
+    }
+
+    void grow (const glm::vec3 &point)
+    {
+      min = glm::vec3(std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z));
+      max = glm::vec3(std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z));
+    }
+
+    float area () const
+    {
+      glm::vec3 size = max - min;
+      return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    bool overlaps (const Bounds &other) const
+    {
+      return min.x <= other.max.x && max.x >= other.min.x &&
+             min.y <= other.max.y && max.y >= other.min.y &&
+             min.z <= other.max.z && max.z >= other.min.z;
+    }
+  };
+
+  // Leaf when count > 0: objects [offset, offset + count) of the leaf
+  // order. Otherwise children at offset and offset + 1
+  struct Node
+  {
+    glm::vec3 min;
+    uint32_t offset;
+    glm::vec3 max;
+    uint32_t count;
+  };
+
+  /**
+   * @brief Builds the tree from scratch.
+   *
+   * @param bounds bounds of every object
+   *
+   * @param pool builds the subtrees in parallel when given and there are
+   *   at least PARALLEL objects
+   */
+  void build (const std::vector<Bounds> &bounds, ThreadPool *pool = NULL)
+  {
+    size_t count = bounds.size();
+    std::vector<Reference> references(count);
+    std::vector<Subtree> subtrees;
+
+    for (size_t i = 0; i < count; i++)
+    {
+      references[i].box = bounds[i];
+      references[i].center = (bounds[i].min + bounds[i].max) * 0.5f;
+      references[i].index = (uint32_t)i;
+    }
+
+    // Node 1 is never used, so that every pair of children starts at an
+    // even index
+    nodes.assign(2, Node());
+    nodes[0].count = 0;
+
+    int splitDepth = -1;
+    if (pool != NULL && pool->size() > 1 && count >= PARALLEL)
+    {
+      splitDepth = (int)std::ceil(std::log2(pool->size() * 4.0));
+    }
+
+    Builder builder{references};
+    levels = count > 0 ? builder.subdivide(nodes, 0, 0, (uint32_t)count, 0, splitDepth, &subtrees) : 0;
+
+    if (!subtrees.empty())
+    {
+      std::vector<std::future<int>> jobs;
+
+      for (Subtree &subtree : subtrees)
+      {
+        jobs.push_back(pool->submit([&builder, &subtree] ()
+        {
+          subtree.nodes.assign(2, Node());
+          return builder.subdivide(subtree.nodes, 0, subtree.first, subtree.last, subtree.depth, -1, NULL);
+        }));
+      }
+
+      for (size_t i = 0; i < subtrees.size(); i++)
+      {
+        levels = std::max(levels, jobs[i].get());
+        splice(subtrees[i]);
+      }
+    }
+
+    indices.resize(count);
+    items.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      indices[i] = references[i].index;
+      items[i] = references[i].box;
+    }
+  }
+
+  /**
+   * @brief Updates the bounds of the tree after the objects moved.
+   *
+   * @param bounds new bounds of the same objects given to build()
+   */
+  void refit (const std::vector<Bounds> &bounds)
+  {
+    for (size_t i = 0; i < items.size(); i++)
+    {
+      items[i] = bounds[indices[i]];
+    }
+
+    // Children always come after their parent
+    for (size_t i = nodes.size(); i-- > 0; )
+    {
+      Node &node = nodes[i];
+      Bounds box;
+
+      if (i == 1 || items.empty())
+      {
+        continue;
+      }
+
+      if (node.count > 0)
+      {
+        for (uint32_t j = node.offset; j < node.offset + node.count; j++)
+        {
+          box.grow(items[j]);
+        }
+      }
+      else
+      {
+        box.grow(nodeBounds(nodes[node.offset]));
+        box.grow(nodeBounds(nodes[node.offset + 1]));
+      }
+
+      node.min = box.min;
+      node.max = box.max;
+    }
+  }
+
+  /**
+   * @brief Calls visit(index) for every object whose bounds may be
+   * inside the frustum.
+   *
+   * Subtrees entirely inside are visited without testing what they hold.
+   */
+  template <typename Visit>
+  void query (const Frustum &frustum, Visit visit) const
+  {
+    const uint32_t INSIDE = 0x80000000u;
+    uint32_t stack[MAX_DEPTH + 2];
+    int top = 0;
+
+    if (items.empty())
+    {
+      return;
+    }
+
+    stack[top++] = 0;
+    while (top > 0)
+    {
+      uint32_t entry = stack[--top];
+      const Node &node = nodes[entry & ~INSIDE];
+      bool inside = (entry & INSIDE) != 0;
+
+      if (!inside)
+      {
+        Frustum::Containment containment = frustum.classifyBox((node.min + node.max) * 0.5f, (node.max - node.min) * 0.5f);
+
+        if (containment == Frustum::OUTSIDE)
+        {
+          continue;
+        }
+        inside = containment == Frustum::INSIDE;
+      }
+
+      if (node.count > 0)
+      {
+        for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+        {
+          if (inside || frustum.containsBox((items[i].min + items[i].max) * 0.5f, (items[i].max - items[i].min) * 0.5f))
+          {
+            visit(indices[i]);
+          }
+        }
+      }
+      else
+      {
+        stack[top++] = (node.offset + 1) | (inside ? INSIDE : 0);
+        stack[top++] = node.offset | (inside ? INSIDE : 0);
+      }
+    }
+  }
+
+  /**
+   * @brief Calls visit(index) for every object whose bounds overlap box.
+   */
+  template <typename Visit>
+  void query (const Bounds &box, Visit visit) const
+  {
+    uint32_t stack[MAX_DEPTH + 2];
+    int top = 0;
+
+    if (items.empty())
+    {
+      return;
+    }
+
+    stack[top++] = 0;
+    while (top > 0)
+    {
+      const Node &node = nodes[stack[--top]];
+
+      if (!box.overlaps(nodeBounds(node)))
+      {
+        continue;
+      }
+
+      if (node.count > 0)
+      {
+        for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+        {
+          if (box.overlaps(items[i]))
+          {
+            visit(indices[i]);
+          }
+        }
+      }
+      else
+      {
+        stack[top++] = node.offset + 1;
+        stack[top++] = node.offset;
+      }
+    }
+  }
+
+  /**
+   * @brief Finds the nearest object hit by a ray.
+   *
+   * @param distance in: how far the ray goes; out: distance to the hit,
+   *   in units of direction
+   *
+   * @param hit hit(index, entry) is called for each object whose bounds
+   *   the ray enters closer than the nearest hit so far, at distance
+   *   entry; it returns the distance to the object itself, or a negative
+   *   value when the ray misses it
+   *
+   * @return index of the object hit, or -1
+   */
+  template <typename Hit>
+  int raycast (const glm::vec3 &origin, const glm::vec3 &direction, float &distance, Hit hit) const
+  {
+    glm::vec3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    uint32_t stack[MAX_DEPTH + 2];
+    int top = 0, nearest = -1;
+
+    if (items.empty() || enter(nodes[0].min, nodes[0].max, origin, inverse, distance) < 0.0f)
+    {
+      return -1;
+    }
+
+    stack[top++] = 0;
+    while (top > 0)
+    {
+      const Node &node = nodes[stack[--top]];
+
+      if (node.count > 0)
+      {
+        for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+        {
+          float entry = enter(items[i].min, items[i].max, origin, inverse, distance);
+
+          if (entry >= 0.0f)
+          {
+            float t = hit(indices[i], entry);
+
+            if (t >= 0.0f && t < distance)
+            {
+              distance = t;
+              nearest = (int)indices[i];
+            }
+          }
+        }
+        continue;
+      }
+
+      // Nearer child on top of the stack, so it can shorten the ray first
+      const Node &left = nodes[node.offset], &right = nodes[node.offset + 1];
+      float leftEntry = enter(left.min, left.max, origin, inverse, distance);
+      float rightEntry = enter(right.min, right.max, origin, inverse, distance);
+
+      if (leftEntry >= 0.0f && rightEntry >= 0.0f)
+      {
+        stack[top++] = leftEntry <= rightEntry ? node.offset + 1 : node.offset;
+        stack[top++] = leftEntry <= rightEntry ? node.offset : node.offset + 1;
+      }
+      else if (leftEntry >= 0.0f)
+      {
+        stack[top++] = node.offset;
+      }
+      else if (rightEntry >= 0.0f)
+      {
+        stack[top++] = node.offset + 1;
+      }
+    }
+
+    return nearest;
+  }
+
+  /**
+   * @brief Finds the nearest object whose bounds are hit by a ray.
+   */
+  int raycast (const glm::vec3 &origin, const glm::vec3 &direction, float &distance) const
+  {
+    return raycast(origin, direction, distance, [] (uint32_t, float entry) { return entry; });
+  }
+
+  /**
+   * @brief Surface area heuristic cost of the tree, relative to the root.
+   *
+   * Expected number of node and object tests of a ray through the root.
+   * A refit tree costs more than a fresh build of the same bounds.
+   */
+  float cost () const
+  {
+    float total = 0.0f;
+
+    if (items.empty())
+    {
+      return 0.0f;
+    }
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+      if (i != 1)
+      {
+        total += nodeBounds(nodes[i]).area() * (nodes[i].count > 0 ? nodes[i].count : 1.0f);
+      }
+    }
+
+    return total / nodeBounds(nodes[0]).area();
+  }
+
+  size_t size () const
+  {
+    return items.size();
+  }
+
+  // Used entries of the node array, the unused node 1 included
+  size_t nodeCount () const
+  {
+    return nodes.size();
+  }
+
+  int depth () const
+  {
+    return levels;
+  }
+
+private:
+  struct Subtree
+  {
+    uint32_t node;
+    uint32_t first, last;
+    int depth;
+    std::vector<Node> nodes;
+  };
+
+  struct Bin
+  {
+    Bounds box;
+    uint32_t count = 0;
+  };
+
+  // What the build moves around: partitioning these rather than indices
+  // keeps every pass over a range sequential in memory
+  struct Reference
+  {
+    Bounds box;
+    glm::vec3 center;
+    uint32_t index;
+  };
+
+  // Splits ranges of references; ranges of different jobs never overlap
+  struct Builder
+  {
+    std::vector<Reference> &references;
+
+    // Fills node with [first, last), at the given depth. Returns the depth
+    // of its deepest leaf. At splitDepth, the range is left to a subtree
+    int subdivide (std::vector<Node> &nodes, uint32_t node, uint32_t first, uint32_t last, int depth, int splitDepth, std::vector<Subtree> *subtrees)
+    {
+      Bounds box, centroids;
+
+      for (uint32_t i = first; i < last; i++)
+      {
+        box.grow(references[i].box);
+        centroids.grow(references[i].center);
+      }
+      nodes[node].min = box.min;
+      nodes[node].max = box.max;
+      nodes[node].offset = first;
+      nodes[node].count = last - first;
+
+      if (depth == splitDepth && last - first > MAX_LEAF)
+      {
+        subtrees->push_back(Subtree{node, first, last, depth, {}});
+        return depth;
+      }
+
+      uint32_t middle;
+      if (depth + 1 >= MAX_DEPTH || !split(centroids, first, last, middle))
+      {
+        return depth;
+      }
+
+      uint32_t children = (uint32_t)nodes.size();
+      nodes.resize(children + 2);
+      nodes[node].offset = children;
+      nodes[node].count = 0;
+
+      int left = subdivide(nodes, children, first, middle, depth + 1, splitDepth, subtrees);
+      int right = subdivide(nodes, children + 1, middle, last, depth + 1, splitDepth, subtrees);
+      return std::max(left, right);
+    }
+
+    // Picks the cheapest of the BINS - 1 planes of each axis and
+    // partitions the range around it. False when the range is a leaf
+    bool split (const Bounds &centroids, uint32_t first, uint32_t last, uint32_t &middle)
+    {
+      uint32_t count = last - first;
+      float bestCost = std::numeric_limits<float>::max();
+      int bestAxis = -1, bestPlane = 0;
+
+      // Small leaves are cheaper to test than to split
+      if (count <= MAX_LEAF)
+      {
+        return false;
+      }
+
+      // One pass over the objects fills the bins of the three axes. Small
+      // ranges get fewer bins, which cost as much to set up as to fill
+      Bin bins[3][BINS];
+      float scale[3];
+      int binCount = (int)std::min<uint32_t>(BINS, count);
+      for (int axis = 0; axis < 3; axis++)
+      {
+        float extent = centroids.max[axis] - centroids.min[axis];
+        scale[axis] = extent > 0.0f ? binCount / extent : 0.0f;
+      }
+
+      for (uint32_t i = first; i < last; i++)
+      {
+        const Reference &reference = references[i];
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+          Bin &bin = bins[axis][bin_of(reference.center[axis], centroids.min[axis], scale[axis], binCount)];
+          bin.box.grow(reference.box);
+          bin.count++;
+        }
+      }
+
+      for (int axis = 0; axis < 3; axis++)
+      {
+        float rightCost[BINS];
+        Bounds left, right;
+        uint32_t leftCount = 0, rightCount = 0;
+
+        if (scale[axis] == 0.0f)
+        {
+          continue;
+        }
+
+        // rightCost[p]: objects of bins p and up, times their area
+        for (int p = binCount - 1; p > 0; p--)
+        {
+          right.grow(bins[axis][p].box);
+          rightCount += bins[axis][p].count;
+          rightCost[p] = rightCount > 0 ? rightCount * right.area() : 0.0f;
+        }
+
+        for (int p = 1; p < binCount; p++)
+        {
+          left.grow(bins[axis][p - 1].box);
+          leftCount += bins[axis][p - 1].count;
+
+          if (leftCount == 0 || leftCount == count)
+          {
+            continue;
+          }
+
+          float cost = leftCount * left.area() + rightCost[p];
+          if (cost < bestCost)
+          {
+            bestCost = cost;
+            bestAxis = axis;
+            bestPlane = p;
+          }
+        }
+      }
+
+      // Every center in the same place: any split is as good as another
+      if (bestAxis < 0)
+      {
+        middle = first + count / 2;
+        return true;
+      }
+
+      Reference *split = std::partition(references.data() + first, references.data() + last, [&] (const Reference &reference)
+      {
+        return bin_of(reference.center[bestAxis], centroids.min[bestAxis], scale[bestAxis], binCount) < bestPlane;
+      });
+
+      middle = (uint32_t)(split - references.data());
+      return true;
+    }
+
+    static int bin_of (float center, float low, float scale, int binCount)
+    {
+      return std::min(binCount - 1, (int)((center - low) * scale));
+    }
+  };
+
+  std::vector<Node> nodes;
+  std::vector<uint32_t> indices;
+  std::vector<Bounds> items;
+  int levels = 0;
+
+  static Bounds nodeBounds (const Node &node)
+  {
+    Bounds box;
+    box.min = node.min;
+    box.max = node.max;
+    return box;
+  }
+
+  // Appends the nodes of a subtree built apart, pairs still at even indices
+  void splice (const Subtree &subtree)
+  {
+    uint32_t shift = (uint32_t)nodes.size() - 2;
+
+    nodes[subtree.node] = subtree.nodes[0];
+    nodes.insert(nodes.end(), subtree.nodes.begin() + 2, subtree.nodes.end());
+
+    if (nodes[subtree.node].count == 0)
+    {
+      nodes[subtree.node].offset += shift;
+    }
+    for (size_t i = shift + 2; i < nodes.size(); i++)
+    {
+      if (nodes[i].count == 0)
+      {
+        nodes[i].offset += shift;
+      }
+    }
+  }
+
+  // Distance at which a ray enters a box (0 when it starts inside), or -1
+  // when it misses it or enters it beyond limit
+  static float enter (const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &origin, const glm::vec3 &inverse, float limit)
+  {
+    float t1 = (min.x - origin.x) * inverse.x, t2 = (max.x - origin.x) * inverse.x;
+    float entry = std::min(t1, t2), exit = std::max(t1, t2);
+
+    t1 = (min.y - origin.y) * inverse.y;
+    t2 = (max.y - origin.y) * inverse.y;
+    entry = std::max(entry, std::min(t1, t2));
+    exit = std::min(exit, std::max(t1, t2));
+
+    t1 = (min.z - origin.z) * inverse.z;
+    t2 = (max.z - origin.z) * inverse.z;
+    entry = std::max(entry, std::min(t1, t2));
+    exit = std::min(exit, std::max(t1, t2));
+
+    if (exit < std::max(entry, 0.0f) || entry > limit)
+    {
+      return -1.0f;
+    }
+
+    return std::max(entry, 0.0f);
+  }
+};
+
+#endif
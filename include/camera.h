@@ -5,8 +5,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstdint>
 #include <vector>
 
+#include "frustum.h"
+
 // Define several possible options for camera movement. Used as abstrac-
 // tion to stay away from window-system specific input methods.
 enum Camera_Movement {
@@ -24,6 +27,9 @@ const float SENSITIVITY = 0.1f;
 const float SPEED = 2.5f;
 const float YAW = -90.0f;
 const float ZOOM = 45.0f;
+const float ASPECT = 800.0f / 600.0f;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
 
 /**
  * @brief Implements a camera
@@ -31,6 +37,20 @@ const float ZOOM = 45.0f;
  * An abstract camera class that processes input and calculates the co-
  * rresponding Euler Angles, Vector and Matrices for use in OpenGL.
  * 
+ * The camera owns its projection (the field of view is Zoom; aspect,
+ * near and far are set with SetProjection) and caches the view and
+ * projection matrices, their product and the inverses of the three.
+ * Each one is computed on first use after the camera changed, so asking
+ * for them every frame costs nothing while the camera stands still.
+ * 
+ * Changes are found by comparing Position, Front, Up and Zoom with the
+ * values the cache was built from, so the Process* methods and direct
+ * writes to these public fields are caught alike, and input that leaves
+ * them as they were (a zero deltaTime, a scroll past the limit of Zoom)
+ * changes nothing. SetProjection and SetAspect mark the projection dirty
+ * when a value differs. GetVersion() grows by
+ * one every time the camera changes, so whoever copies the matrices
+ * (uniform uploads, culling) can skip its work while it stays the same.
  */
 class Camera
 {
@@ -90,14 +110,156 @@ public:
     updateCameraVectors();
   }
 
+  /**
+   * @brief Set the projection parameters
+   * 
+   * @param aspect width / height of the viewport
+   * 
+   * @param nearPlane distance to the near clipping plane
+   * 
+   * @param farPlane distance to the far clipping plane
+   */
+  void SetProjection (float aspect, float nearPlane = NEAR_PLANE, float farPlane = FAR_PLANE)
+  {
+    projectionDirty |= aspect != Aspect || nearPlane != Near || farPlane != Far;
+    Aspect = aspect;
+    Near = nearPlane;
+    Far = farPlane;
+  }
+
+  /**
+   * @brief Set the aspect ratio, e.g. when the framebuffer is resized
+   * 
+   * @param aspect width / height of the viewport
+   */
+  void SetAspect (float aspect)
+  {
+    projectionDirty |= aspect != Aspect;
+    Aspect = aspect;
+  }
+
+  float GetAspect () const
+  {
+    return Aspect;
+  }
+
+  float GetNear () const
+  {
+    return Near;
+  }
+
+  float GetFar () const
+  {
+    return Far;
+  }
+
   /**
    * @brief Get the View Matrix object
    * 
-   * @return glm::mat4 
+   * @return const glm::mat4& 
+   */
+  const glm::mat4 &GetViewMatrix () const
+  {
+    refresh();
+    if (stale & VIEW)
+    {
+      view = glm::lookAt(Position, Position + Front, Up);
+      stale &= ~VIEW;
+    }
+    return view;
+  }
+
+  /**
+   * @brief Get the projection built from Zoom and SetProjection()
+   * 
+   * @return const glm::mat4& 
    */
-  glm::mat4 GetViewMatrix ()
+  const glm::mat4 &GetProjectionMatrix () const
   {
-    return glm::lookAt(Position, Position + Front, Up);
+    refresh();
+    if (stale & PROJECTION)
+    {
+      projection = glm::perspective(glm::radians(Zoom), Aspect, Near, Far);
+      stale &= ~PROJECTION;
+    }
+    return projection;
+  }
+
+  /**
+   * @brief Get projection * view
+   * 
+   * @return const glm::mat4& 
+   */
+  const glm::mat4 &GetViewProjectionMatrix () const
+  {
+    refresh();
+    if (stale & VIEW_PROJECTION)
+    {
+      viewProjection = GetProjectionMatrix() * GetViewMatrix();
+      stale &= ~VIEW_PROJECTION;
+    }
+    return viewProjection;
+  }
+
+  const glm::mat4 &GetInverseViewMatrix () const
+  {
+    refresh();
+    if (stale & INVERSE_VIEW)
+    {
+      inverseView = glm::inverse(GetViewMatrix());
+      stale &= ~INVERSE_VIEW;
+    }
+    return inverseView;
+  }
+
+  const glm::mat4 &GetInverseProjectionMatrix () const
+  {
+    refresh();
+    if (stale & INVERSE_PROJECTION)
+    {
+      inverseProjection = glm::inverse(GetProjectionMatrix());
+      stale &= ~INVERSE_PROJECTION;
+    }
+    return inverseProjection;
+  }
+
+  /**
+   * @brief Get the inverse of projection * view, which takes points from
+   * clip space back to the world (e.g. to pick with the mouse)
+   * 
+   * @return const glm::mat4& 
+   */
+  const glm::mat4 &GetInverseViewProjectionMatrix () const
+  {
+    refresh();
+    if (stale & INVERSE_VIEW_PROJECTION)
+    {
+      inverseViewProjection = glm::inverse(GetViewProjectionMatrix());
+      stale &= ~INVERSE_VIEW_PROJECTION;
+    }
+    return inverseViewProjection;
+  }
+
+  /**
+   * @brief Get the world-space frustum of GetViewProjectionMatrix(), so
+   * what it culls is exactly what would be clipped
+   * 
+   * @return Frustum 
+   */
+  Frustum GetFrustum () const
+  {
+    return Frustum::fromMatrix(GetViewProjectionMatrix());
+  }
+
+  /**
+   * @brief Get a number that grows every time the camera changes
+   * 
+   * @return uint64_t 
+   */
+  uint64_t GetVersion () const
+  {
+    refresh();
+    return version;
   }
 
   /**
@@ -114,6 +276,8 @@ public:
   {
     float velocity = MovementSpeed * deltaTime;
 
+    // Nothing is marked dirty here: refresh() compares Position with the
+    // one the view was built from, so a zero deltaTime keeps the version
     if (direction == FORWARD)
     {
       Position += Front * velocity;
@@ -185,6 +349,8 @@ public:
    */
   void ProcessMouseScroll (float yOffset)
   {
+    // refresh() compares Zoom with the one the projection was built
+    // from, so scrolling past a limit keeps the version
     Zoom -= (float)yOffset;
 
     if (Zoom < 1.0f)
@@ -198,6 +364,66 @@ public:
   }
 
 private:
+  enum Matrix
+  {
+    VIEW = 1,
+    PROJECTION = 2,
+    VIEW_PROJECTION = 4,
+    INVERSE_VIEW = 8,
+    INVERSE_PROJECTION = 16,
+    INVERSE_VIEW_PROJECTION = 32
+  };
+
+  // Projection options
+  float Aspect = ASPECT;
+  float Near = NEAR_PLANE;
+  float Far = FAR_PLANE;
+
+  // Cached matrices, and what they were computed from
+  mutable glm::mat4 view, projection, viewProjection;
+  mutable glm::mat4 inverseView, inverseProjection, inverseViewProjection;
+  mutable glm::vec3 viewPosition, viewFront, viewUp;
+  mutable float projectionZoom = 0.0f;
+  mutable unsigned int stale = 0;
+  mutable bool viewDirty = true;
+  mutable bool projectionDirty = true;
+  mutable uint64_t version = 0;
+
+/**
+ * @brief Marks stale the matrices whose inputs changed since the last
+ * call, and counts a new version if any did
+ * 
+ */
+  void refresh () const
+  {
+    bool viewChanged = viewDirty || Position != viewPosition || Front != viewFront || Up != viewUp;
+    bool projectionChanged = projectionDirty || Zoom != projectionZoom;
+
+    if (!viewChanged && !projectionChanged)
+    {
+      return;
+    }
+
+    if (viewChanged)
+    {
+      stale |= VIEW | INVERSE_VIEW;
+      viewPosition = Position;
+      viewFront = Front;
+      viewUp = Up;
+      viewDirty = false;
+    }
+
+    if (projectionChanged)
+    {
+      stale |= PROJECTION | INVERSE_PROJECTION;
+      projectionZoom = Zoom;
+      projectionDirty = false;
+    }
+
+    stale |= VIEW_PROJECTION | INVERSE_VIEW_PROJECTION;
+    version++;
+  }
+
 /**
  * @brief Calculates the front vector from the camera's Euler Angles
  * 
@@ -0,0 +1,224 @@
+#ifndef CPU_TRACER_H
+#define CPU_TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Records the CPU time of scopes, on any thread, for a Chrome trace.
+ *
+ *   void process_input (GLFWwindow *window)
+ *   {
+ *     PROFILE_CPU("process_input");
+ *     ...
+ *   }
+ *
+ *   CpuTracer::instance().writeTrace("cpu-trace.json");
+ *
+ * Every thread writes into a ring buffer of its own, allocated the first
+ * time it records a scope. After that, recording an event is two clock
+ * reads, a store into the ring and a release store of its head: no
+ * allocation, no lock and no contention between threads. When a ring
+ * wraps the oldest events are overwritten, so a long run keeps its last
+ * CAPACITY events per thread.
+ *
+ * writeTrace() reads the rings without stopping the writers; call it once
+ * the traced threads are idle (e.g. at exit) for an exact result.
+ *
+ * Define LEARNGL_NO_CPU_TRACER to compile PROFILE_CPU and
+ * PROFILE_CPU_THREAD out; the tracer then records nothing.
+ */
+class CpuTracer
+{
+  struct Buffer;
+
+public:
+  // Events kept per thread, a power of two
+  static const size_t CAPACITY = 1 << 16;
+
+  /**
+   * @brief Records a complete event for the lifetime of the object.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope (const char *_name) : name(_name), buffer(CpuTracer::local())
+    {
+      depth = buffer->depth++;
+      start = CpuTracer::now();
+    }
+
+    ~Scope ()
+    {
+      uint64_t end = CpuTracer::now();
+      uint64_t head = buffer->head.load(std::memory_order_relaxed);
+      Event &event = buffer->events[head & (CAPACITY - 1)];
+
+      event.name = name;
+      event.start = start;
+      event.duration = end - start;
+      event.depth = depth;
+
+      buffer->depth--;
+      buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    Scope (const Scope &) = delete;
+    Scope &operator= (const Scope &) = delete;
+
+  private:
+    const char *name;
+    Buffer *buffer;
+    uint64_t start;
+    unsigned int depth;
+  };
+
+  static CpuTracer &instance ()
+  {
+    static CpuTracer tracer;
+    return tracer;
+  }
+
+  /**
+   * @brief Names the calling thread in the trace.
+   */
+  static void setThreadName (const char *name)
+  {
+    Buffer *buffer = local();
+
+    strncpy(buffer->name, name, sizeof(buffer->name) - 1);
+    buffer->name[sizeof(buffer->name) - 1] = '\0';
+  }
+
+  /**
+   * @brief Saves the events of every thread as Chrome trace JSON.
+   */
+  bool writeTrace (const std::string &path)
+  {
+    std::ofstream file(path);
+
+    if (!file)
+    {
+      std::cout << "ERROR::CPU_TRACER::TRACE_NOT_WRITABLE " << path << std::endl;
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    bool first = true;
+    uint64_t written = 0, lost = 0;
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+
+    for (const std::unique_ptr<Buffer> &buffer : buffers)
+    {
+      uint64_t head = buffer->head.load(std::memory_order_acquire);
+      uint64_t tail = head > CAPACITY ? head - CAPACITY : 0;
+
+      file << (first ? "\n" : ",\n")
+           << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << buffer->id
+           << ", \"args\": {\"name\": \"" << buffer->name << "\"}}";
+      first = false;
+
+      for (uint64_t i = tail; i < head; i++)
+      {
+        const Event &event = buffer->events[i & (CAPACITY - 1)];
+
+        file << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 0"
+             << ", \"tid\": " << buffer->id
+             << ", \"ts\": " << event.start / 1000.0
+             << ", \"dur\": " << event.duration / 1000.0
+             << ", \"args\": {\"depth\": " << event.depth << "}}";
+      }
+
+      written += head - tail;
+      lost += tail;
+    }
+
+    file << "\n]}\n";
+
+    std::cout << "CPU tracer: " << written << " events from " << buffers.size() << " threads written to "
+              << path << ", " << lost << " overwritten" << std::endl;
+    return true;
+  }
+
+private:
+  struct Event
+  {
+    const char *name;
+    uint64_t start;
+    uint64_t duration;
+    unsigned int depth;
+  };
+
+  // Written only by its thread; the head is published with release so a
+  // reader that acquires it sees every event before it
+  struct Buffer
+  {
+    Event events[CAPACITY];
+    std::atomic<uint64_t> head{0};
+    unsigned int depth = 0;
+    unsigned int id = 0;
+    char name[32] = "";
+  };
+
+  CpuTracer () : origin(std::chrono::steady_clock::now()) {}
+
+  // Nanoseconds since the tracer was created
+  static uint64_t now ()
+  {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - instance().origin).count();
+  }
+
+  // The buffer of the calling thread. Buffers live as long as the tracer,
+  // so the events of threads that already exited are still written
+  static Buffer *local ()
+  {
+    thread_local Buffer *buffer = NULL;
+
+    if (!buffer)
+    {
+      buffer = instance().registerThread();
+    }
+
+    return buffer;
+  }
+
+  Buffer *registerThread ()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    buffers.emplace_back(new Buffer());
+    Buffer *buffer = buffers.back().get();
+    buffer->id = (unsigned int)buffers.size();
+    snprintf(buffer->name, sizeof(buffer->name), "thread %u", buffer->id);
+
+    return buffer;
+  }
+
+  std::chrono::steady_clock::time_point origin;
+  std::vector<std::unique_ptr<Buffer>> buffers;
+  std::mutex mutex;
+};
+
+#define CPU_TRACER_CONCAT_(a, b) a##b
+#define CPU_TRACER_CONCAT(a, b) CPU_TRACER_CONCAT_(a, b)
+
+#ifdef LEARNGL_NO_CPU_TRACER
+#define PROFILE_CPU(name) ((void)0)
+#define PROFILE_CPU_THREAD(name) ((void)0)
+#else
+#define PROFILE_CPU(name) CpuTracer::Scope CPU_TRACER_CONCAT(cpuScope, __COUNTER__)(name)
+#define PROFILE_CPU_THREAD(name) CpuTracer::setThreadName(name)
+#endif
+
+#endif
@@ -5,6 +5,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "gl_state.h"
+
 class Cube
 {
 public:
@@ -36,16 +38,22 @@ public:
     if (VAO)
     {
       glDeleteVertexArrays(1, &VAO);
+      GLState::instance().deleted(VAO);
+      VAO = 0;
     }
 
     if (VBO)
     {
       glDeleteBuffers(1, &VBO);
+      GLState::instance().deleted(VBO);
+      VBO = 0;
     }
 
     if (EBO)
     {
       glDeleteBuffers(1, &EBO);
+      GLState::instance().deleted(EBO);
+      EBO = 0;
     }
   }
 
@@ -53,16 +61,38 @@ public:
    * @brief Dibuja el cubo.
    * 
    * El método asocia el objeto de búfer del cubo (el cual contiene toda
-   * la información del cubo), lo dibuja y después, desasocia el objeto
-   * de búfer, para que éste no interfiera con otros objetos.
+   * la información del cubo) y lo dibuja. La asociación pasa por GLState,
+   * así que dibujar varias veces seguidas el mismo cubo no vuelve a aso-
+   * ciarlo; tampoco se desasocia al terminar, GLState sabe qué está aso-
+   * ciado y los demás objetos asocian el suyo a través de él.
    */
   void draw ()
   {
     if (VAO)
     {
-      glBindVertexArray(VAO);
+      GLState::instance().bindVertexArray(VAO);
       glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-      glBindVertexArray(0);
+    }
+    else
+    {
+      std::cout << "The VAO is empty! Did you initialize the cube?" << std::endl;
+    }
+  }
+
+  /**
+   * @brief Dibuja varias copias del cubo con una sola llamada.
+   * 
+   * Los atributos por instancia (p. ej. la matriz de modelo de cada
+   * copia) deben estar ya configurados en el VAO, ver CubeInstances.
+   * 
+   * @param count el número de copias
+   */
+  void drawInstanced (GLsizei count)
+  {
+    if (VAO)
+    {
+      GLState::instance().bindVertexArray(VAO);
+      glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, count);
     }
     else
     {
@@ -85,18 +115,29 @@ public:
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState &state = GLState::instance();
+
+    state.bindVertexArray(VAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    state.bindVertexArray(0);
+    state.bindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  /**
+   * @brief Get the VAO
+   * 
+   * @return unsigned int el VAO con los vértices del cubo (atributo 0)
+   */
+  unsigned int getVAO ()
+  {
+    return VAO;
   }
 
   /**
@@ -173,7 +214,7 @@ private:
      0.5f, -0.5f, -0.5f   // 7
   };
 
-  unsigned int EBO, VAO, VBO;
+  unsigned int EBO = 0, VAO = 0, VBO = 0;
 
   glm::mat4 model;
 };
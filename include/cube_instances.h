@@ -0,0 +1,126 @@
+#ifndef CUBE_INSTANCES_H
+#define CUBE_INSTANCES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "cube.h"
+#include "gl_state.h"
+
+/**
+ * @brief Draws many copies of a Cube with one draw call.
+ *
+ * The model matrix of every copy lives in an instance buffer attached to
+ * the cube's VAO as a mat4 attribute (locations 3 to 6) with divisor 1,
+ * so the vertex shader reads the matrix of its copy instead of a "model"
+ * uniform (see shaders/cube-color.vs.glsl, built with INSTANCED defined).
+ * Each frame the matrices are streamed into the buffer once and drawn
+ * with a single glDrawElementsInstanced, instead of one uniform upload
+ * and one draw per cube.
+ */
+class CubeInstances
+{
+public:
+  // First attribute location of the per-instance model matrix
+  static const GLuint MODEL_LOCATION = 3;
+
+  // Must be called with the GL context current
+  explicit CubeInstances (size_t capacity = 1024)
+  {
+    GLState &state = GLState::instance();
+
+    glGenBuffers(1, &instanceVBO);
+    state.bindVertexArray(cube.getVAO());
+    state.bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    reserve(capacity);
+
+    // A mat4 attribute takes four consecutive vec4 locations
+    for (GLuint i = 0; i < 4; i++)
+    {
+      glVertexAttribPointer(MODEL_LOCATION + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+      glEnableVertexAttribArray(MODEL_LOCATION + i);
+      glVertexAttribDivisor(MODEL_LOCATION + i, 1);
+    }
+
+    state.bindVertexArray(0);
+  }
+
+  ~CubeInstances ()
+  {
+    clear();
+  }
+
+  CubeInstances (const CubeInstances &) = delete;
+  CubeInstances &operator= (const CubeInstances &) = delete;
+
+  /**
+   * @brief Uploads the model matrix of every copy.
+   *
+   * The previous contents are orphaned first, so the driver hands out
+   * fresh storage instead of waiting for the frame that still reads it.
+   */
+  void update (const glm::mat4 *models, size_t _count)
+  {
+    count = _count;
+    GLState::instance().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    if (count > capacity)
+    {
+      reserve(count + count / 2);
+    }
+    else
+    {
+      glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+    }
+
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), models);
+  }
+
+  void update (const std::vector<glm::mat4> &models)
+  {
+    update(models.data(), models.size());
+  }
+
+  // Draws every copy given to the last update()
+  void draw ()
+  {
+    if (count > 0)
+    {
+      cube.drawInstanced((GLsizei)count);
+    }
+  }
+
+  size_t size () const
+  {
+    return count;
+  }
+
+  void clear ()
+  {
+    if (instanceVBO)
+    {
+      glDeleteBuffers(1, &instanceVBO);
+      GLState::instance().deleted(instanceVBO);
+      instanceVBO = 0;
+    }
+    cube.clear();
+    count = capacity = 0;
+  }
+
+private:
+  // Grows the instance buffer, which must be bound to GL_ARRAY_BUFFER
+  void reserve (size_t _capacity)
+  {
+    capacity = _capacity;
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+  }
+
+  Cube cube;
+  unsigned int instanceVBO = 0;
+  size_t capacity = 0;
+  size_t count = 0;
+};
+
+#endif
@@ -20,6 +20,9 @@ const float SENSITIVITY = 0.1f;
 const float SPEED = 2.5f;
 const float YAW = -90.0f;
 const float ZOOM = 45.0f;
+const float ASPECT = 800.0f / 600.0f;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
 
 class Camera
 {
@@ -93,6 +96,31 @@ public:
     return rotation * translation;*/
   }
 
+  void SetProjection (float aspect, float nearPlane = NEAR_PLANE, float farPlane = FAR_PLANE)
+  {
+    Aspect = aspect;
+    Near = nearPlane;
+    Far = farPlane;
+    projectionZoom = 0.0f;
+  }
+
+  void SetAspect (float aspect)
+  {
+    Aspect = aspect;
+    projectionZoom = 0.0f;
+  }
+
+  // Recomputed only after Zoom or the projection parameters changed
+  const glm::mat4 &GetProjectionMatrix ()
+  {
+    if (Zoom != projectionZoom)
+    {
+      projection = glm::perspective(glm::radians(Zoom), Aspect, Near, Far);
+      projectionZoom = Zoom;
+    }
+    return projection;
+  }
+
   void ProcessKeyboard (Camera_Movement direction, float deltaTime)
   {
     float velocity = deltaTime * MovementSpeed;
@@ -152,6 +180,14 @@ public:
   }
 
 private:
+  float Aspect = ASPECT;
+  float Near = NEAR_PLANE;
+  float Far = FAR_PLANE;
+
+  // Zoom the projection was computed with, 0 (never a valid Zoom) when stale
+  glm::mat4 projection;
+  float projectionZoom = 0.0f;
+
   void updateCameraVectors()
   {
     glm::vec3 front;
@@ -0,0 +1,181 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Per-frame CPU time, GPU time and draw calls of a measured run.
+ *
+ * CPU time is the wall time from beginFrame() to endFrame(), so it
+ * includes the buffer swap. GPU time comes from a GL_TIME_ELAPSED query
+ * around the rendering commands (beginFrame() to endRender()). There is
+ * one query per measured frame and none is read before resolve(), so the
+ * measurement never waits for the GPU while the run is going.
+ */
+class FrameStats
+{
+public:
+  struct Summary
+  {
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+  };
+
+  // Must be called with the GL context current
+  explicit FrameStats (size_t frames) : queries(frames)
+  {
+    glGenQueries((GLsizei)queries.size(), queries.data());
+    cpuMs.reserve(frames);
+    draws.reserve(frames);
+  }
+
+  ~FrameStats ()
+  {
+    clear();
+  }
+
+  FrameStats (const FrameStats &) = delete;
+  FrameStats &operator= (const FrameStats &) = delete;
+
+  void beginFrame ()
+  {
+    start = std::chrono::steady_clock::now();
+
+    if (cpuMs.size() < queries.size())
+    {
+      glBeginQuery(GL_TIME_ELAPSED, queries[cpuMs.size()]);
+    }
+  }
+
+  // Call after the last draw of the frame, before swapping
+  void endRender (unsigned int drawCalls)
+  {
+    if (cpuMs.size() < queries.size())
+    {
+      glEndQuery(GL_TIME_ELAPSED);
+    }
+    draws.push_back(drawCalls);
+  }
+
+  void endFrame ()
+  {
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    cpuMs.push_back(elapsed.count());
+  }
+
+  /**
+   * @brief Reads the GPU times back, waiting for the last frames.
+   */
+  void resolve ()
+  {
+    gpuMs.clear();
+
+    for (size_t i = 0; i < cpuMs.size() && i < queries.size(); i++)
+    {
+      GLuint64 nanoseconds = 0;
+      glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+      gpuMs.push_back(nanoseconds / 1e6);
+    }
+  }
+
+  size_t frames () const
+  {
+    return cpuMs.size();
+  }
+
+  Summary cpu () const
+  {
+    return summarize(cpuMs);
+  }
+
+  Summary gpu () const
+  {
+    return summarize(gpuMs);
+  }
+
+  // Draw calls of the frame with the most of them
+  unsigned int maxDraws () const
+  {
+    return draws.empty() ? 0 : *std::max_element(draws.begin(), draws.end());
+  }
+
+  /**
+   * @brief {"frames": N, "draw_calls": D, "cpu_ms": {...}, "gpu_ms": {...}}
+   */
+  std::string json () const
+  {
+    std::ostringstream out;
+
+    out << "{\"frames\": " << frames()
+        << ", \"draw_calls\": " << maxDraws()
+        << ", \"cpu_ms\": " << json(cpu())
+        << ", \"gpu_ms\": " << json(gpu()) << "}";
+
+    return out.str();
+  }
+
+  void clear ()
+  {
+    if (!queries.empty())
+    {
+      glDeleteQueries((GLsizei)queries.size(), queries.data());
+      queries.clear();
+    }
+  }
+
+  /**
+   * @brief Nearest-rank percentile of sorted values.
+   */
+  static double percentile (const std::vector<double> &sorted, double p)
+  {
+    if (sorted.empty())
+    {
+      return 0.0;
+    }
+
+    size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.999999);
+    rank = rank < 1 ? 1 : (rank > sorted.size() ? sorted.size() : rank);
+
+    return sorted[rank - 1];
+  }
+
+private:
+  static Summary summarize (std::vector<double> values)
+  {
+    Summary summary;
+
+    std::sort(values.begin(), values.end());
+    summary.p50 = percentile(values, 50.0);
+    summary.p95 = percentile(values, 95.0);
+    summary.p99 = percentile(values, 99.0);
+    summary.max = values.empty() ? 0.0 : values.back();
+
+    return summary;
+  }
+
+  static std::string json (const Summary &summary)
+  {
+    std::ostringstream out;
+
+    out << "{\"p50\": " << summary.p50 << ", \"p95\": " << summary.p95
+        << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << "}";
+
+    return out.str();
+  }
+
+  std::vector<GLuint> queries;
+  std::vector<double> cpuMs;
+  std::vector<double> gpuMs;
+  std::vector<unsigned int> draws;
+  std::chrono::steady_clock::time_point start;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gl_state.h"
+
+/**
+ * @brief Per-frame values shared by every program through a uniform
+ * buffer: the "Frame" block of shaders/common/frame.glsl.
+ *
+ * The buffer is written once per frame and stays bound to BINDING, so
+ * the programs that attach the block (Shader::bindUniformBlock) read the
+ * camera from it instead of receiving their own copy of every matrix.
+ * Shaders declare the block when built with FRAME_UNIFORMS defined.
+ */
+class FrameUniforms
+{
+public:
+  // Binding point of the block, the same for every program
+  static const GLuint BINDING = 0;
+
+  // Name of the block in the shaders
+  static constexpr const char *BLOCK = "Frame";
+
+  // Define that makes frame.glsl declare the block
+  static constexpr const char *DEFINE = "#define FRAME_UNIFORMS 1\n";
+
+  // std140 layout of the block: mat4s are 4 vec4 columns, and the vec3 is
+  // padded to 16 bytes unless a scalar follows it, as time does here
+  struct Block
+  {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    float time;
+  };
+
+  static_assert(sizeof(Block) == 144, "Frame block must match the std140 layout");
+
+  // Must be called with the GL context current
+  FrameUniforms ()
+  {
+    glGenBuffers(1, &UBO);
+    GLState::instance().bindBufferBase(GL_UNIFORM_BUFFER, BINDING, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_DYNAMIC_DRAW);
+  }
+
+  FrameUniforms (const FrameUniforms &) = delete;
+  FrameUniforms &operator= (const FrameUniforms &) = delete;
+
+  /**
+   * @brief Uploads the values of this frame, one buffer write for all
+   * programs.
+   */
+  void update (const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPos, float time)
+  {
+    Block block = {view, projection, viewPos, time};
+
+    GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+    uploaded = false;
+  }
+
+  /**
+   * @brief Uploads the values of this frame, skipping the camera part
+   * when it has not changed since the last upload.
+   *
+   * @param cameraVersion Camera::GetVersion() of the camera the matrices
+   *   come from; while it stays the same only time is written
+   */
+  void update (const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &viewPos, float time, uint64_t cameraVersion)
+  {
+    if (!uploaded || cameraVersion != version)
+    {
+      update(view, projection, viewPos, time);
+      uploaded = true;
+      version = cameraVersion;
+      return;
+    }
+
+    GLState::instance().bindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(Block, time), sizeof(float), &time);
+  }
+
+  void clear ()
+  {
+    glDeleteBuffers(1, &UBO);
+    GLState::instance().deleted(UBO);
+    UBO = 0;
+    uploaded = false;
+  }
+
+private:
+  unsigned int UBO = 0;
+
+  // Camera version of the matrices in the buffer, when uploaded
+  uint64_t version = 0;
+  bool uploaded = false;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+/**
+ * @brief The six planes of a view frustum, in world space.
+ *
+ * Each plane is stored as (normal, distance) with the normal pointing
+ * inwards, so a point p is inside when dot(normal, p) + distance >= 0
+ * for all of them. Order: left, right, bottom, top, near, far.
+ *
+ * The sums are grouped as in FrustumCuller, which takes the same
+ * decisions in batches as long as the compiler does not fuse the
+ * multiplies and adds of one and not of the other: builds for a CPU with
+ * FMA need -ffp-contract=off, which LEARNGL_NATIVE passes.
+ *
+ * The tests here are conservative: a box or sphere that crosses a plane
+ * is kept, and a few that are outside but near a corner of the frustum
+ * are kept as well. Nothing visible is ever culled.
+ */
+struct Frustum
+{
+  enum Plane { LEFT, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANES };
+
+  enum Containment { OUTSIDE, INTERSECTS, INSIDE };
+
+  glm::vec4 planes[PLANES];
+
+  /**
+   * @brief Extracts the planes from a projection * view matrix.
+   *
+   * The rows of the matrix are combined as in Gribb and Hartmann, "Fast
+   * extraction of viewing frustum planes from the world-view-projection
+   * matrix", for OpenGL clip space (-w <= z <= w). With a projection
+   * alone the planes are in view space; with projection * view * model,
+   * in the space of the model.
+   */
+  static Frustum fromMatrix (const glm::mat4 &matrix)
+  {
+    Frustum frustum;
+
+    // glm is column-major: matrix[column][row]
+    glm::vec4 x(matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0]);
+    glm::vec4 y(matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1]);
+    glm::vec4 z(matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]);
+    glm::vec4 w(matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]);
+
+    frustum.planes[LEFT] = w + x;
+    frustum.planes[RIGHT] = w - x;
+    frustum.planes[BOTTOM] = w + y;
+    frustum.planes[TOP] = w - y;
+    frustum.planes[NEAR_PLANE] = w + z;
+    frustum.planes[FAR_PLANE] = w - z;
+
+    // Unit normals, so that distances can be compared with radii
+    for (glm::vec4 &plane : frustum.planes)
+    {
+      float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+      plane = plane / length;
+    }
+
+    return frustum;
+  }
+
+  /**
+   * @brief Whether an axis-aligned box may be visible.
+   *
+   * @param center center of the box
+   *
+   * @param extents half of its size along each axis
+   */
+  bool containsBox (const glm::vec3 &center, const glm::vec3 &extents) const
+  {
+    for (const glm::vec4 &plane : planes)
+    {
+      float distance = (plane.x * center.x + plane.y * center.y) + (plane.z * center.z + plane.w);
+      float radius = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+
+      if (distance + radius < 0.0f)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Whether an axis-aligned box is outside, crosses a plane or is
+   * entirely inside; hierarchies use INSIDE to skip testing what it holds.
+   */
+  Containment classifyBox (const glm::vec3 &center, const glm::vec3 &extents) const
+  {
+    Containment containment = INSIDE;
+
+    for (const glm::vec4 &plane : planes)
+    {
+      float distance = (plane.x * center.x + plane.y * center.y) + (plane.z * center.z + plane.w);
+      float radius = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+
+      if (distance + radius < 0.0f)
+      {
+        return OUTSIDE;
+      }
+      if (distance - radius < 0.0f)
+      {
+        containment = INTERSECTS;
+      }
+    }
+
+    return containment;
+  }
+
+  /**
+   * @brief Whether a sphere may be visible.
+   */
+  bool containsSphere (const glm::vec3 &center, float radius) const
+  {
+    for (const glm::vec4 &plane : planes)
+    {
+      float distance = (plane.x * center.x + plane.y * center.y) + (plane.z * center.z + plane.w);
+
+      if (distance + radius < 0.0f)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+};
+
+#endif
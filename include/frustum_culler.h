@@ -0,0 +1,353 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_CULLER_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRUSTUM_CULLER_SSE2 1
+#endif
+
+#include "frustum.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Culls many bounding volumes against a Frustum at once.
+ *
+ *   FrustumCuller::Boxes boxes;
+ *   boxes.add(min, max);                                  // once per object
+ *
+ *   Frustum frustum = camera.GetFrustum();
+ *   FrustumCuller::cull(frustum, boxes, visible, &pool);  // every frame
+ *   for (size_t i = 0; i < boxes.size(); i++)
+ *     if (visible[i]) draw(i);
+ *
+ * The volumes are kept as structures of arrays (one array per component),
+ * so 8 of them are tested against a plane with a handful of vector
+ * instructions: one AVX register, or two SSE2 registers, per component.
+ * The arrays are padded to a multiple of 8, and there is a scalar
+ * fallback. The decisions are the same as those of Frustum::containsBox()
+ * when multiply-adds are not fused (see Frustum).
+ *
+ * With a ThreadPool and at least PARALLEL volumes, the arrays are split
+ * into ranges of whole batches, one job each. Every job writes its own
+ * part of the result, so no lock is taken.
+ */
+class FrustumCuller
+{
+public:
+  static constexpr size_t BATCH = 8;
+  static constexpr size_t PARALLEL = 1 << 16;
+
+  // Axis-aligned boxes, as center and half extents
+  struct Boxes
+  {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    size_t add (const glm::vec3 &min, const glm::vec3 &max)
+    {
+      if (count == centerX.size())
+      {
+        for (std::vector<float> *component : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+        {
+          component->resize(count + BATCH, 0.0f);
+        }
+      }
+
+      set(count, min, max);
+      return count++;
+    }
+
+    void set (size_t i, const glm::vec3 &min, const glm::vec3 &max)
+    {
+      centerX[i] = (min.x + max.x) * 0.5f;
+      centerY[i] = (min.y + max.y) * 0.5f;
+      centerZ[i] = (min.z + max.z) * 0.5f;
+      extentX[i] = (max.x - min.x) * 0.5f;
+      extentY[i] = (max.y - min.y) * 0.5f;
+      extentZ[i] = (max.z - min.z) * 0.5f;
+    }
+
+    size_t size () const
+    {
+      return count;
+    }
+
+    void clear ()
+    {
+      for (std::vector<float> *component : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+      {
+        component->clear();
+      }
+      count = 0;
+    }
+
+  private:
+    size_t count = 0;
+  };
+
+  // Spheres, as center and radius
+  struct Spheres
+  {
+    std::vector<float> centerX, centerY, centerZ, radius;
+
+    size_t add (const glm::vec3 &center, float r)
+    {
+      if (count == centerX.size())
+      {
+        for (std::vector<float> *component : {&centerX, &centerY, &centerZ, &radius})
+        {
+          component->resize(count + BATCH, 0.0f);
+        }
+      }
+
+      set(count, center, r);
+      return count++;
+    }
+
+    void set (size_t i, const glm::vec3 &center, float r)
+    {
+      centerX[i] = center.x;
+      centerY[i] = center.y;
+      centerZ[i] = center.z;
+      radius[i] = r;
+    }
+
+    size_t size () const
+    {
+      return count;
+    }
+
+    void clear ()
+    {
+      for (std::vector<float> *component : {&centerX, &centerY, &centerZ, &radius})
+      {
+        component->clear();
+      }
+      count = 0;
+    }
+
+  private:
+    size_t count = 0;
+  };
+
+  /**
+   * @brief Tests every box against the frustum.
+   *
+   * @param visible resized to boxes.size(); 1 where the box may be
+   *   visible, 0 where it is certainly not
+   *
+   * @param pool spreads the work over its threads when given and there
+   *   are at least PARALLEL boxes
+   *
+   * @return number of boxes that may be visible
+   */
+  static size_t cull (const Frustum &frustum, const Boxes &boxes, std::vector<uint8_t> &visible, ThreadPool *pool = NULL)
+  {
+    return run(boxes.size(), visible, pool, [&frustum, &boxes, &visible] (size_t first, size_t last)
+    {
+      return cullBoxes(frustum, boxes, visible.data(), first, last);
+    });
+  }
+
+  /**
+   * @brief Tests every sphere against the frustum, as cull() for boxes.
+   */
+  static size_t cull (const Frustum &frustum, const Spheres &spheres, std::vector<uint8_t> &visible, ThreadPool *pool = NULL)
+  {
+    return run(spheres.size(), visible, pool, [&frustum, &spheres, &visible] (size_t first, size_t last)
+    {
+      return cullSpheres(frustum, spheres, visible.data(), first, last);
+    });
+  }
+
+private:
+  // Splits [0, count) into ranges of whole batches and runs test on them
+  template <typename Test>
+  static size_t run (size_t count, std::vector<uint8_t> &visible, ThreadPool *pool, Test test)
+  {
+    visible.resize(count);
+
+    if (pool == NULL || pool->size() < 2 || count < PARALLEL)
+    {
+      return test(0, count);
+    }
+
+    // A few ranges per thread, so that a slow one does not hold the rest
+    size_t batches = (count + BATCH - 1) / BATCH;
+    size_t jobs = std::min(batches, (size_t)pool->size() * 4);
+    size_t step = (batches + jobs - 1) / jobs * BATCH;
+    std::vector<std::future<size_t>> results;
+
+    for (size_t first = 0; first < count; first += step)
+    {
+      size_t last = std::min(count, first + step);
+      results.push_back(pool->submit([&test, first, last] () { return test(first, last); }));
+    }
+
+    size_t inside = 0;
+    for (std::future<size_t> &result : results)
+    {
+      inside += result.get();
+    }
+
+    return inside;
+  }
+
+  // Writes the 8 bits of mask to visible[i..last), at most 8 of them
+  static size_t store (uint8_t *visible, size_t i, size_t last, int mask)
+  {
+    size_t n = std::min(BATCH, last - i), inside = 0;
+
+    for (size_t k = 0; k < n; k++)
+    {
+      visible[i + k] = (uint8_t)((mask >> k) & 1);
+      inside += visible[i + k];
+    }
+
+    return inside;
+  }
+
+  // first is a multiple of BATCH; the padding past the end is read, not written
+  static size_t cullBoxes (const Frustum &frustum, const Boxes &boxes, uint8_t *visible, size_t first, size_t last)
+  {
+    const float *cx = boxes.centerX.data(), *cy = boxes.centerY.data(), *cz = boxes.centerZ.data();
+    const float *ex = boxes.extentX.data(), *ey = boxes.extentY.data(), *ez = boxes.extentZ.data();
+    size_t inside = 0;
+
+#if defined(FRUSTUM_CULLER_AVX)
+    for (size_t i = first; i < last; i += BATCH)
+    {
+      __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+      __m256 hx = _mm256_loadu_ps(ex + i), hy = _mm256_loadu_ps(ey + i), hz = _mm256_loadu_ps(ez + i);
+      __m256 in = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+      for (const glm::vec4 &plane : frustum.planes)
+      {
+        __m256 distance = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+          _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+        __m256 radius = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(hx, _mm256_set1_ps(std::fabs(plane.x))), _mm256_mul_ps(hy, _mm256_set1_ps(std::fabs(plane.y)))),
+          _mm256_mul_ps(hz, _mm256_set1_ps(std::fabs(plane.z))));
+
+        in = _mm256_and_ps(in, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+      }
+
+      inside += store(visible, i, last, _mm256_movemask_ps(in));
+    }
+#elif defined(FRUSTUM_CULLER_SSE2)
+    for (size_t i = first; i < last; i += BATCH)
+    {
+      int mask = 0;
+
+      // The two halves of the batch
+      for (size_t half = 0; half < BATCH; half += 4)
+      {
+        size_t j = i + half;
+        __m128 x = _mm_loadu_ps(cx + j), y = _mm_loadu_ps(cy + j), z = _mm_loadu_ps(cz + j);
+        __m128 hx = _mm_loadu_ps(ex + j), hy = _mm_loadu_ps(ey + j), hz = _mm_loadu_ps(ez + j);
+        __m128 in = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+          __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+            _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+          __m128 radius = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(hx, _mm_set1_ps(std::fabs(plane.x))), _mm_mul_ps(hy, _mm_set1_ps(std::fabs(plane.y)))),
+            _mm_mul_ps(hz, _mm_set1_ps(std::fabs(plane.z))));
+
+          in = _mm_and_ps(in, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        mask |= _mm_movemask_ps(in) << half;
+      }
+
+      inside += store(visible, i, last, mask);
+    }
+#else
+    for (size_t i = first; i < last; i++)
+    {
+      visible[i] = frustum.containsBox(glm::vec3(cx[i], cy[i], cz[i]), glm::vec3(ex[i], ey[i], ez[i])) ? 1 : 0;
+      inside += visible[i];
+    }
+#endif
+
+    return inside;
+  }
+
+  static size_t cullSpheres (const Frustum &frustum, const Spheres &spheres, uint8_t *visible, size_t first, size_t last)
+  {
+    const float *cx = spheres.centerX.data(), *cy = spheres.centerY.data(), *cz = spheres.centerZ.data();
+    const float *r = spheres.radius.data();
+    size_t inside = 0;
+
+#if defined(FRUSTUM_CULLER_AVX)
+    for (size_t i = first; i < last; i += BATCH)
+    {
+      __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+      __m256 radius = _mm256_loadu_ps(r + i);
+      __m256 in = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+      for (const glm::vec4 &plane : frustum.planes)
+      {
+        __m256 distance = _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+          _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+
+        in = _mm256_and_ps(in, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+      }
+
+      inside += store(visible, i, last, _mm256_movemask_ps(in));
+    }
+#elif defined(FRUSTUM_CULLER_SSE2)
+    for (size_t i = first; i < last; i += BATCH)
+    {
+      int mask = 0;
+
+      for (size_t half = 0; half < BATCH; half += 4)
+      {
+        size_t j = i + half;
+        __m128 x = _mm_loadu_ps(cx + j), y = _mm_loadu_ps(cy + j), z = _mm_loadu_ps(cz + j);
+        __m128 radius = _mm_loadu_ps(r + j);
+        __m128 in = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+          __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+            _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+
+          in = _mm_and_ps(in, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        mask |= _mm_movemask_ps(in) << half;
+      }
+
+      inside += store(visible, i, last, mask);
+    }
+#else
+    for (size_t i = first; i < last; i++)
+    {
+      visible[i] = frustum.containsSphere(glm::vec3(cx[i], cy[i], cz[i]), r[i]) ? 1 : 0;
+      inside += visible[i];
+    }
+#endif
+
+    return inside;
+  }
+};
+
+#endif
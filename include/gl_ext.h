@@ -0,0 +1,163 @@
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// The bundled glad loader only covers OpenGL 3.3 core. Entry points from
+// newer versions or extensions are loaded here, on demand, with the same
+// loader function given to gladLoadGLLoader.
+
+// ARB_get_program_binary (core in 4.1)
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+// KHR_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// ARB_buffer_storage (core in 4.4)
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+// EXT_texture_compression_s3tc, ARB_texture_compression_bptc (core in 4.2)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+typedef void (APIENTRYP PFNGLEXTGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLEXTPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLEXTPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLEXTMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+typedef void (APIENTRYP PFNGLEXTBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+/**
+ * @brief Entry points and flags of the extensions used by the helpers.
+ *
+ * A null pointer (or a false flag) means the extension is not available
+ * and callers must take their core 3.3 path.
+ */
+struct GLExtensions
+{
+  bool loaded = false;
+
+  bool ARB_get_program_binary = false;
+  PFNGLEXTGETPROGRAMBINARYPROC GetProgramBinary = NULL;
+  PFNGLEXTPROGRAMBINARYPROC ProgramBinary = NULL;
+  PFNGLEXTPROGRAMPARAMETERIPROC ProgramParameteri = NULL;
+
+  bool KHR_parallel_shader_compile = false;
+  PFNGLEXTMAXSHADERCOMPILERTHREADSKHRPROC MaxShaderCompilerThreadsKHR = NULL;
+
+  bool ARB_buffer_storage = false;
+  PFNGLEXTBUFFERSTORAGEPROC BufferStorage = NULL;
+};
+
+inline GLExtensions &gl_ext ()
+{
+  static GLExtensions extensions;
+  return extensions;
+}
+
+/**
+ * @brief Checks whether the current context exposes an extension.
+ *
+ * @param name the extension name, e.g. "GL_ARB_get_program_binary"
+ */
+inline bool gl_has_extension (const char *name)
+{
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+  for (GLint i = 0; i < count; i++)
+  {
+    const char *extension = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+
+    if (extension && strcmp(extension, name) == 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Checks whether glCompressedTexImage2D takes one of the block
+ * compressed formats above. The answer is cached for the process.
+ */
+inline bool gl_supports_compressed_format (GLenum internalFormat)
+{
+  static const bool s3tc = gl_has_extension("GL_EXT_texture_compression_s3tc");
+  static const bool bptc = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 2) ||
+                           gl_has_extension("GL_ARB_texture_compression_bptc");
+
+  switch (internalFormat)
+  {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+      return s3tc;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+      return bptc;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Loads the extension entry points for the current context.
+ *
+ * Must be called after gladLoadGLLoader, with the same loader. Calling
+ * it more than once is harmless.
+ *
+ * @param load the loader, e.g. (GLADloadproc)glfwGetProcAddress
+ */
+inline void gl_ext_load (GLADloadproc load)
+{
+  GLExtensions &ext = gl_ext();
+
+  if (ext.loaded)
+  {
+    return;
+  }
+  ext.loaded = true;
+
+  bool core41 = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+  if (core41 || gl_has_extension("GL_ARB_get_program_binary"))
+  {
+    ext.GetProgramBinary = (PFNGLEXTGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+    ext.ProgramBinary = (PFNGLEXTPROGRAMBINARYPROC)load("glProgramBinary");
+    ext.ProgramParameteri = (PFNGLEXTPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+    ext.ARB_get_program_binary = ext.GetProgramBinary && ext.ProgramBinary && ext.ProgramParameteri;
+  }
+
+  if (gl_has_extension("GL_KHR_parallel_shader_compile"))
+  {
+    ext.MaxShaderCompilerThreadsKHR = (PFNGLEXTMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+    ext.KHR_parallel_shader_compile = ext.MaxShaderCompilerThreadsKHR != NULL;
+  }
+
+  bool core44 = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4);
+  if (core44 || gl_has_extension("GL_ARB_buffer_storage"))
+  {
+    ext.BufferStorage = (PFNGLEXTBUFFERSTORAGEPROC)load("glBufferStorage");
+    ext.ARB_buffer_storage = ext.BufferStorage != NULL;
+  }
+}
+
+#endif
@@ -0,0 +1,410 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+/**
+ * @brief Shadow copy of the GL bindings, to skip redundant state changes.
+ *
+ * Every setter compares against the value it last set and only calls GL
+ * when it differs, so "bind, draw, unbind" sequences and repeated
+ * glUseProgram calls cost nothing once the state is already right. The
+ * calls issued and filtered are counted per frame.
+ *
+ * Tracked: program, VAO, the buffer of each common target, the texture
+ * of each target on each unit, the active unit, and depth/blend state.
+ *
+ * GL state belongs to a context and a context is current on one thread
+ * at a time, so there is one cache per thread (see instance()). Code that
+ * changes the tracked state with raw gl* calls must call invalidate()
+ * afterwards, otherwise the cache may skip a call that is needed.
+ */
+class GLState
+{
+public:
+  struct Stats
+  {
+    unsigned int issued = 0;
+    unsigned int filtered = 0;
+  };
+
+  // Texture units tracked; binds on higher units are always issued
+  static const unsigned int MAX_UNITS = 32;
+
+  static GLState &instance ()
+  {
+    static thread_local GLState state;
+    return state;
+  }
+
+  void useProgram (GLuint program)
+  {
+    if (program != this->program)
+    {
+      this->program = program;
+      issue();
+      glUseProgram(program);
+    }
+    else
+    {
+      stats.filtered++;
+    }
+  }
+
+  void bindVertexArray (GLuint vao)
+  {
+    if (vao != vertexArray)
+    {
+      vertexArray = vao;
+      issue();
+      glBindVertexArray(vao);
+
+      // The element buffer binding is part of the VAO
+      buffers[ELEMENT] = UNKNOWN;
+    }
+    else
+    {
+      stats.filtered++;
+    }
+  }
+
+  void bindBuffer (GLenum target, GLuint buffer)
+  {
+    int slot = bufferSlot(target);
+
+    if (slot < 0 || buffers[slot] != buffer)
+    {
+      if (slot >= 0)
+      {
+        buffers[slot] = buffer;
+      }
+      issue();
+      glBindBuffer(target, buffer);
+    }
+    else
+    {
+      stats.filtered++;
+    }
+  }
+
+  // glBindBufferBase also replaces the generic binding of the target
+  void bindBufferBase (GLenum target, GLuint index, GLuint buffer)
+  {
+    int slot = bufferSlot(target);
+
+    if (slot >= 0)
+    {
+      buffers[slot] = buffer;
+    }
+    issue();
+    glBindBufferBase(target, index, buffer);
+  }
+
+  void activeTexture (unsigned int unit)
+  {
+    if (unit != activeUnit)
+    {
+      activeUnit = unit;
+      issue();
+      glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    else
+    {
+      stats.filtered++;
+    }
+  }
+
+  /**
+   * @brief Binds a texture to a unit, changing the active unit only if
+   * the binding has to be issued.
+   */
+  void bindTexture (unsigned int unit, GLenum target, GLuint texture)
+  {
+    int slot = textureSlot(target);
+
+    if (unit < MAX_UNITS && slot >= 0 && textures[unit][slot] == texture)
+    {
+      stats.filtered++;
+      return;
+    }
+
+    activeTexture(unit);
+    if (unit < MAX_UNITS && slot >= 0)
+    {
+      textures[unit][slot] = texture;
+    }
+    issue();
+    glBindTexture(target, texture);
+  }
+
+  void enable (GLenum capability)
+  {
+    setCapability(capability, true);
+  }
+
+  void disable (GLenum capability)
+  {
+    setCapability(capability, false);
+  }
+
+  void depthFunc (GLenum func)
+  {
+    if (func != depthFunction)
+    {
+      depthFunction = func;
+      issue();
+      glDepthFunc(func);
+    }
+    else
+    {
+      stats.filtered++;
+    }
+  }
+
+  void depthMask (bool write)
+  {
+    GLenum value = write ? GL_TRUE : GL_FALSE;
+
+    if (value != depthWrite)
+    {
+      depthWrite = value;
+      issue();
+      glDepthMask((GLboolean)write);
+    }
+    else
+    {
+      stats.filtered++;
+    }
+  }
+
+  void blendFunc (GLenum source, GLenum destination)
+  {
+    if (source != blendSource || destination != blendDestination)
+    {
+      blendSource = source;
+      blendDestination = destination;
+      issue();
+      glBlendFunc(source, destination);
+    }
+    else
+    {
+      stats.filtered++;
+    }
+  }
+
+  /**
+   * @brief Forgets a deleted object, so a new object reusing its name is
+   * bound again. Call after glDelete* of a program, VAO, buffer or texture.
+   */
+  void deleted (GLuint name)
+  {
+    if (program == name)
+    {
+      program = UNKNOWN;
+    }
+    if (vertexArray == name)
+    {
+      vertexArray = UNKNOWN;
+      buffers[ELEMENT] = UNKNOWN;
+    }
+    for (GLuint &buffer : buffers)
+    {
+      buffer = buffer == name ? UNKNOWN : buffer;
+    }
+    for (auto &unit : textures)
+    {
+      for (GLuint &texture : unit)
+      {
+        texture = texture == name ? UNKNOWN : texture;
+      }
+    }
+  }
+
+  /**
+   * @brief Forgets every shadowed value; the next call of each setter is
+   * issued. Use after changing tracked state with raw gl* calls.
+   */
+  void invalidate ()
+  {
+    program = vertexArray = UNKNOWN;
+    activeUnit = UNKNOWN;
+    depthFunction = depthWrite = blendSource = blendDestination = UNKNOWN;
+
+    for (GLuint &buffer : buffers)
+    {
+      buffer = UNKNOWN;
+    }
+    for (auto &unit : textures)
+    {
+      for (GLuint &texture : unit)
+      {
+        texture = UNKNOWN;
+      }
+    }
+    for (GLenum &capability : capabilities)
+    {
+      capability = UNKNOWN;
+    }
+  }
+
+  /**
+   * @brief Returns the counters of the frame that just ended and starts
+   * counting the next one. Call once per frame, e.g. after swapping.
+   */
+  Stats endFrame ()
+  {
+    Stats frame = stats;
+
+    frames++;
+    total.issued += stats.issued;
+    total.filtered += stats.filtered;
+    stats = Stats();
+
+    return frame;
+  }
+
+  /**
+   * @brief Prints the average calls issued and filtered per frame.
+   */
+  void report () const
+  {
+    if (frames == 0)
+    {
+      return;
+    }
+
+    unsigned int calls = total.issued + total.filtered;
+
+    std::cout << "GL state cache over " << frames << " frames:" << std::endl;
+    std::cout << "  issued per frame:   " << (double)total.issued / frames << std::endl;
+    std::cout << "  filtered per frame: " << (double)total.filtered / frames << std::endl;
+    std::cout << "  filtered:           " << (calls ? 100.0 * total.filtered / calls : 0.0) << "%" << std::endl;
+  }
+
+private:
+  // Value that never matches, so the next call is issued
+  static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+  enum BufferSlot
+  {
+    ARRAY,
+    ELEMENT,
+    UNIFORM,
+    PIXEL_UNPACK,
+    PIXEL_PACK,
+    COPY_READ,
+    COPY_WRITE,
+    BUFFER_SLOTS
+  };
+
+  enum TextureSlot
+  {
+    TEXTURE_2D,
+    TEXTURE_3D,
+    TEXTURE_CUBE_MAP,
+    TEXTURE_2D_ARRAY,
+    TEXTURE_SLOTS
+  };
+
+  enum CapabilitySlot
+  {
+    DEPTH_TEST,
+    BLEND,
+    CULL_FACE,
+    CAPABILITY_SLOTS
+  };
+
+  GLState ()
+  {
+    invalidate();
+  }
+
+  static int bufferSlot (GLenum target)
+  {
+    switch (target)
+    {
+      case GL_ARRAY_BUFFER:         return ARRAY;
+      case GL_ELEMENT_ARRAY_BUFFER: return ELEMENT;
+      case GL_UNIFORM_BUFFER:       return UNIFORM;
+      case GL_PIXEL_UNPACK_BUFFER:  return PIXEL_UNPACK;
+      case GL_PIXEL_PACK_BUFFER:    return PIXEL_PACK;
+      case GL_COPY_READ_BUFFER:     return COPY_READ;
+      case GL_COPY_WRITE_BUFFER:    return COPY_WRITE;
+      default:                      return -1;
+    }
+  }
+
+  static int textureSlot (GLenum target)
+  {
+    switch (target)
+    {
+      case GL_TEXTURE_2D:       return TEXTURE_2D;
+      case GL_TEXTURE_3D:       return TEXTURE_3D;
+      case GL_TEXTURE_CUBE_MAP: return TEXTURE_CUBE_MAP;
+      case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+      default:                  return -1;
+    }
+  }
+
+  static int capabilitySlot (GLenum capability)
+  {
+    switch (capability)
+    {
+      case GL_DEPTH_TEST: return DEPTH_TEST;
+      case GL_BLEND:      return BLEND;
+      case GL_CULL_FACE:  return CULL_FACE;
+      default:            return -1;
+    }
+  }
+
+  void setCapability (GLenum capability, bool on)
+  {
+    int slot = capabilitySlot(capability);
+    GLenum value = on ? GL_TRUE : GL_FALSE;
+
+    if (slot >= 0 && capabilities[slot] == value)
+    {
+      stats.filtered++;
+      return;
+    }
+
+    if (slot >= 0)
+    {
+      capabilities[slot] = value;
+    }
+    issue();
+
+    if (on)
+    {
+      glEnable(capability);
+    }
+    else
+    {
+      glDisable(capability);
+    }
+  }
+
+  void issue ()
+  {
+    stats.issued++;
+  }
+
+  GLuint program;
+  GLuint vertexArray;
+  GLuint buffers[BUFFER_SLOTS];
+  GLuint activeUnit;
+  GLuint textures[MAX_UNITS][TEXTURE_SLOTS];
+  GLenum capabilities[CAPABILITY_SLOTS];
+  GLenum depthFunction;
+  GLenum depthWrite;
+  GLenum blendSource;
+  GLenum blendDestination;
+
+  Stats stats;
+  Stats total;
+  unsigned int frames = 0;
+};
+
+#endif
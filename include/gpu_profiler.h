@@ -0,0 +1,387 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Measures GPU time of nested scopes with timestamp queries.
+ *
+ *   GpuProfiler::instance().beginFrame();
+ *   {
+ *     PROFILE_GPU("lighting-pass");
+ *     ...draws...
+ *   }
+ *   GpuProfiler::instance().endFrame();
+ *
+ * beginFrame() and endFrame() open and close a "frame" scope themselves.
+ *
+ * Each scope takes two GL_TIMESTAMP queries (glQueryCounter) from a pool;
+ * timestamps, unlike GL_TIME_ELAPSED, can nest. The queries of a frame
+ * are read FRAMES_IN_FLIGHT frames later, and only if the GPU already
+ * has them, so the profiler never waits for the pipeline to drain. A
+ * frame whose results are still missing when its slot in the ring comes
+ * back is dropped (and counted) instead of waited for.
+ *
+ * Resolved scopes feed a rolling average per name, printed by report(),
+ * and a trace that writeTrace() saves in the Chrome trace event format
+ * (open it in chrome://tracing or Perfetto).
+ *
+ * Define LEARNGL_NO_GPU_PROFILER to compile PROFILE_GPU out. Use from the
+ * thread that owns the GL context.
+ */
+class GpuProfiler
+{
+public:
+  static const unsigned int FRAMES_IN_FLIGHT = 4;
+
+  // Samples in the rolling average of each scope
+  static const unsigned int WINDOW = 120;
+
+  // Scopes kept for the trace; once it is full, new ones are not recorded
+  static const size_t MAX_TRACE_EVENTS = 200000;
+
+  struct Average
+  {
+    double milliseconds = 0.0;
+    unsigned int samples = 0;
+  };
+
+  /**
+   * @brief Opens and closes a scope for the lifetime of the object.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope (const char *name)
+    {
+      GpuProfiler::instance().push(name);
+    }
+
+    ~Scope ()
+    {
+      GpuProfiler::instance().pop();
+    }
+
+    Scope (const Scope &) = delete;
+    Scope &operator= (const Scope &) = delete;
+  };
+
+  static GpuProfiler &instance ()
+  {
+    static GpuProfiler profiler;
+    return profiler;
+  }
+
+  /**
+   * @brief Starts recording a frame, inside a "frame" scope that every
+   * other scope nests in. Collects every older frame whose results are
+   * available.
+   */
+  void beginFrame ()
+  {
+    for (unsigned int i = 1; i < FRAMES_IN_FLIGHT; i++)
+    {
+      collect(frames[(current + i) % FRAMES_IN_FLIGHT], false);
+    }
+
+    // The slot about to be reused: take what is there, never wait
+    Frame &frame = frames[current];
+    collect(frame, true);
+
+    frame.number = frameNumber++;
+    frame.recording = true;
+    depth = 0;
+    open.clear();
+    push("frame");
+  }
+
+  void endFrame ()
+  {
+    while (!open.empty())
+    {
+      pop();
+    }
+    frames[current].recording = false;
+    current = (current + 1) % FRAMES_IN_FLIGHT;
+  }
+
+  // Prefer PROFILE_GPU, which pairs push and pop. The name is kept by
+  // pointer, so it must be a string literal (or outlive the profiler)
+  void push (const char *name)
+  {
+    Frame &frame = frames[current];
+
+    if (!frame.recording)
+    {
+      return;
+    }
+
+    Event event;
+    event.name = name;
+    event.depth = depth++;
+    event.begin = acquire();
+    event.end = 0;
+    glQueryCounter(event.begin, GL_TIMESTAMP);
+    frame.last = event.begin;
+
+    open.push_back(frame.events.size());
+    frame.events.push_back(event);
+  }
+
+  void pop ()
+  {
+    Frame &frame = frames[current];
+
+    if (!frame.recording || open.empty())
+    {
+      return;
+    }
+
+    Event &event = frame.events[open.back()];
+    open.pop_back();
+    depth--;
+
+    event.end = acquire();
+    glQueryCounter(event.end, GL_TIMESTAMP);
+    frame.last = event.end;
+  }
+
+  /**
+   * @brief Rolling average GPU time of a scope, in milliseconds.
+   */
+  Average average (const std::string &name) const
+  {
+    Average result;
+    auto found = scopes.find(name);
+
+    if (found != scopes.end() && !found->second.samples.empty())
+    {
+      double sum = 0.0;
+      for (double sample : found->second.samples)
+      {
+        sum += sample;
+      }
+      result.samples = (unsigned int)found->second.samples.size();
+      result.milliseconds = sum / result.samples;
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Prints the rolling average of every scope.
+   */
+  void report () const
+  {
+    std::cout << "GPU profiler, average of the last " << WINDOW << " frames:" << std::endl;
+    for (const auto &scope : scopes)
+    {
+      std::cout << "  " << std::string(scope.second.depth * 2, ' ') << scope.first << ": "
+                << average(scope.first).milliseconds << " ms" << std::endl;
+    }
+    std::cout << "  frames resolved: " << resolved << ", dropped: " << dropped << std::endl;
+  }
+
+  /**
+   * @brief Saves the resolved scopes as Chrome trace JSON.
+   */
+  bool writeTrace (const std::string &path) const
+  {
+    std::ofstream file(path);
+
+    if (!file)
+    {
+      std::cout << "ERROR::GPU_PROFILER::TRACE_NOT_WRITABLE " << path << std::endl;
+      return false;
+    }
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"GPU\"}}";
+
+    for (const TraceEvent &event : trace)
+    {
+      file << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"gpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+           << ", \"ts\": " << (event.start - origin) / 1000.0
+           << ", \"dur\": " << event.duration / 1000.0
+           << ", \"args\": {\"frame\": " << event.frame << "}}";
+    }
+
+    file << "\n]}\n";
+    return true;
+  }
+
+  /**
+   * @brief Deletes every query. Call before destroying the context.
+   */
+  void clear ()
+  {
+    for (Frame &frame : frames)
+    {
+      release(frame);
+    }
+    if (!pool.empty())
+    {
+      glDeleteQueries((GLsizei)pool.size(), pool.data());
+      pool.clear();
+    }
+  }
+
+private:
+  struct Event
+  {
+    const char *name;
+    unsigned int depth;
+    GLuint begin;
+    GLuint end;
+  };
+
+  struct Frame
+  {
+    std::vector<Event> events;
+    GLuint last = 0;
+    uint64_t number = 0;
+    bool recording = false;
+  };
+
+  struct ScopeStats
+  {
+    std::vector<double> samples;
+    size_t next = 0;
+    unsigned int depth = 0;
+  };
+
+  struct TraceEvent
+  {
+    const char *name;
+    uint64_t start;
+    uint64_t duration;
+    uint64_t frame;
+  };
+
+  GpuProfiler () {}
+
+  GLuint acquire ()
+  {
+    GLuint query;
+
+    if (pool.empty())
+    {
+      glGenQueries(1, &query);
+      return query;
+    }
+
+    query = pool.back();
+    pool.pop_back();
+    return query;
+  }
+
+  void release (Frame &frame)
+  {
+    for (const Event &event : frame.events)
+    {
+      pool.push_back(event.begin);
+      if (event.end)
+      {
+        pool.push_back(event.end);
+      }
+    }
+    frame.events.clear();
+  }
+
+  // Reads a finished frame if the GPU has its results; a reused slot
+  // that is still waiting is dropped
+  void collect (Frame &frame, bool reuse)
+  {
+    if (frame.events.empty() || frame.recording)
+    {
+      return;
+    }
+
+    // Queries complete in order, the last one issued tells for the frame
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(frame.last, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if (!available)
+    {
+      if (reuse)
+      {
+        dropped++;
+        release(frame);
+      }
+      return;
+    }
+
+    for (const Event &event : frame.events)
+    {
+      if (!event.end)
+      {
+        continue;
+      }
+
+      GLuint64 begin = 0, end = 0;
+      glGetQueryObjectui64v(event.begin, GL_QUERY_RESULT, &begin);
+      glGetQueryObjectui64v(event.end, GL_QUERY_RESULT, &end);
+      record(event, begin, end, frame.number);
+    }
+
+    resolved++;
+    release(frame);
+  }
+
+  void record (const Event &event, uint64_t begin, uint64_t end, uint64_t frameNumber)
+  {
+    ScopeStats &scope = scopes[event.name];
+    double milliseconds = (end - begin) / 1e6;
+
+    scope.depth = event.depth;
+    if (scope.samples.size() < WINDOW)
+    {
+      scope.samples.push_back(milliseconds);
+    }
+    else
+    {
+      scope.samples[scope.next] = milliseconds;
+      scope.next = (scope.next + 1) % WINDOW;
+    }
+
+    if (origin == 0)
+    {
+      origin = begin;
+    }
+    if (trace.size() < MAX_TRACE_EVENTS)
+    {
+      trace.push_back(TraceEvent{event.name, begin, end - begin, frameNumber});
+    }
+  }
+
+  Frame frames[FRAMES_IN_FLIGHT];
+  unsigned int current = 0;
+  uint64_t frameNumber = 0;
+  unsigned int depth = 0;
+  std::vector<size_t> open;
+  std::vector<GLuint> pool;
+
+  std::map<std::string, ScopeStats> scopes;
+  std::vector<TraceEvent> trace;
+  uint64_t origin = 0;
+  unsigned int resolved = 0;
+  unsigned int dropped = 0;
+};
+
+#define GPU_PROFILER_CONCAT_(a, b) a##b
+#define GPU_PROFILER_CONCAT(a, b) GPU_PROFILER_CONCAT_(a, b)
+
+#ifdef LEARNGL_NO_GPU_PROFILER
+#define PROFILE_GPU(name) ((void)0)
+#else
+#define PROFILE_GPU(name) GpuProfiler::Scope GPU_PROFILER_CONCAT(gpuScope, __COUNTER__)(name)
+#endif
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Runs an example without a display, e.g. on CI or a render farm.
+ *
+ * Selected with command-line flags:
+ *
+ *   --headless[=FRAMES]      render FRAMES frames (default 300) and exit
+ *   --headless-api=API       egl (surfaceless, default) or osmesa
+ *   --headless-output=FILE   save the last frame as a binary PPM
+ *
+ * It uses the null platform of GLFW 3.4, so every glfw* call of the
+ * examples keeps working (windows are virtual, input never arrives) and
+ * the context comes from EGL on EGL_MESA_platform_surfaceless or from
+ * OSMesa, both of which run on Mesa's llvmpipe without a GPU. Rendering
+ * goes into a framebuffer object the size of the window, bound in place
+ * of the default framebuffer.
+ *
+ * An example only needs three calls: init() instead of glfwInit(),
+ * attach() after loading glad, and frame() after swapping buffers. All
+ * three do nothing without --headless.
+ */
+class Headless
+{
+public:
+  static Headless &instance ()
+  {
+    static Headless headless;
+    return headless;
+  }
+
+  /**
+   * @brief Parses the flags and initializes GLFW.
+   *
+   * @return the result of glfwInit()
+   */
+  int init (int argc, char **argv)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      const char *arg = argv[i];
+
+      if (strcmp(arg, "--headless") == 0)
+      {
+        enabled = true;
+      }
+      else if (strncmp(arg, "--headless=", 11) == 0)
+      {
+        enabled = true;
+        frames = atoi(arg + 11) > 0 ? atoi(arg + 11) : frames;
+      }
+      else if (strncmp(arg, "--headless-api=", 15) == 0)
+      {
+        osmesa = strcmp(arg + 15, "osmesa") == 0;
+      }
+      else if (strncmp(arg, "--headless-output=", 18) == 0)
+      {
+        output = arg + 18;
+      }
+    }
+
+#ifdef GLFW_PLATFORM_NULL
+    if (enabled)
+    {
+      glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+#else
+    if (enabled)
+    {
+      std::cout << "ERROR::HEADLESS::NEEDS_GLFW_3_4, running with a window" << std::endl;
+      enabled = false;
+    }
+#endif
+
+    int result = glfwInit();
+
+#ifdef GLFW_PLATFORM_NULL
+    if (enabled)
+    {
+      glfwWindowHint(GLFW_CONTEXT_CREATION_API, osmesa ? GLFW_OSMESA_CONTEXT_API : GLFW_EGL_CONTEXT_API);
+      glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+#endif
+
+    return result;
+  }
+
+  bool isEnabled () const
+  {
+    return enabled;
+  }
+
+  /**
+   * @brief Creates the framebuffer object and binds it. Call once the GL
+   * functions are loaded.
+   */
+  void attach (GLFWwindow *window)
+  {
+    if (!enabled)
+    {
+      return;
+    }
+
+    glfwGetFramebufferSize(window, &width, &height);
+
+    glGenFramebuffers(1, &FBO);
+    glGenRenderbuffers(2, RBO);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, RBO[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, RBO[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, RBO[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, RBO[1]);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+      std::cout << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+
+    glViewport(0, 0, width, height);
+    std::cout << "Headless: " << width << "x" << height << ", " << frames << " frames, "
+              << glGetString(GL_RENDERER) << std::endl;
+
+    start = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * @brief Counts a frame; after the last one prints the timing, saves
+   * the image if asked and closes the window.
+   */
+  void frame (GLFWwindow *window)
+  {
+    if (!enabled || ++rendered < frames)
+    {
+      return;
+    }
+
+    glFinish();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Headless: " << rendered << " frames in " << elapsed.count() << " s, "
+              << elapsed.count() / rendered * 1000.0 << " ms/frame, "
+              << rendered / elapsed.count() << " fps" << std::endl;
+
+    if (!output.empty())
+    {
+      save(output);
+    }
+
+    glfwSetWindowShouldClose(window, true);
+  }
+
+private:
+  Headless () {}
+
+  // Writes the color attachment as a binary PPM, top row first
+  void save (const std::string &path)
+  {
+    std::vector<unsigned char> pixels((size_t)width * height * 3);
+    FILE *file = fopen(path.c_str(), "wb");
+
+    if (!file)
+    {
+      std::cout << "ERROR::HEADLESS::OUTPUT_NOT_WRITABLE " << path << std::endl;
+      return;
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    for (int y = height - 1; y >= 0; y--)
+    {
+      fwrite(&pixels[(size_t)y * width * 3], 1, (size_t)width * 3, file);
+    }
+    fclose(file);
+  }
+
+  bool enabled = false;
+  bool osmesa = false;
+  int frames = 300;
+  int rendered = 0;
+  int width = 0;
+  int height = 0;
+  std::string output;
+  unsigned int FBO = 0;
+  unsigned int RBO[2] = {0, 0};
+  std::chrono::steady_clock::time_point start;
+};
+
+#endif
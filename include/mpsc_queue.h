@@ -0,0 +1,98 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Lock-free queue with many producers and one consumer.
+ *
+ * Producers (e.g. ThreadPool workers) push with a compare-and-swap on the
+ * head of a linked list. The consumer takes the whole list with a single
+ * exchange and reverses it, so items come out in the order they were
+ * pushed. Since the consumer never removes nodes one at a time, there is
+ * no ABA problem to guard against.
+ *
+ * push() allocates a node; neither side ever takes a lock or waits for
+ * the other.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  MpscQueue () {}
+
+  ~MpscQueue ()
+  {
+    Node *node = head.exchange(nullptr, std::memory_order_acquire);
+
+    while (node)
+    {
+      Node *next = node->next;
+      delete node;
+      node = next;
+    }
+  }
+
+  MpscQueue (const MpscQueue &) = delete;
+  MpscQueue &operator= (const MpscQueue &) = delete;
+
+  // Any thread
+  void push (T value)
+  {
+    Node *node = new Node{std::move(value), head.load(std::memory_order_relaxed)};
+
+    while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+  }
+
+  /**
+   * @brief Moves every queued item to the end of out, oldest first.
+   *
+   * Only one thread may consume.
+   *
+   * @return the number of items taken
+   */
+  size_t popAll (std::vector<T> &out)
+  {
+    Node *node = head.exchange(nullptr, std::memory_order_acquire);
+    Node *reversed = nullptr;
+    size_t count = 0;
+
+    while (node)
+    {
+      Node *next = node->next;
+      node->next = reversed;
+      reversed = node;
+      node = next;
+    }
+
+    while (reversed)
+    {
+      Node *next = reversed->next;
+      out.push_back(std::move(reversed->value));
+      delete reversed;
+      reversed = next;
+      count++;
+    }
+
+    return count;
+  }
+
+  bool empty () const
+  {
+    return head.load(std::memory_order_relaxed) == nullptr;
+  }
+
+private:
+  struct Node
+  {
+    T value;
+    Node *next;
+  };
+
+  std::atomic<Node *> head{nullptr};
+};
+
+#endif
@@ -0,0 +1,309 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gl_ext.h"
+
+/**
+ * @brief Persistent on-disk cache of linked program binaries.
+ *
+ * Programs are stored with glGetProgramBinary under a cache directory,
+ * keyed by a hash of the shader sources and of the driver's vendor,
+ * renderer and version strings. On the next run glProgramBinary loads
+ * them back, skipping compilation and linking. Whenever the driver re-
+ * jects a binary (e.g. after an update) the caller compiles normally and
+ * the entry is overwritten.
+ *
+ * The cache is opt-in: it does nothing until enable() is called.
+ */
+class ProgramCache
+{
+public:
+  // Hit/miss statistics, used to compare cold and warm startups
+  struct Stats
+  {
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+    unsigned int rejected = 0;
+    double compileSeconds = 0.0;
+    double loadSeconds = 0.0;
+    double savedSeconds = 0.0;
+  };
+
+  static ProgramCache &instance ()
+  {
+    static ProgramCache cache;
+    return cache;
+  }
+
+  /**
+   * @brief Turns the cache on for the current context.
+   *
+   * Stays disabled if the driver cannot retrieve program binaries.
+   *
+   * @param _directory where the binaries are stored, created if needed
+   *
+   * @param load the loader given to gladLoadGLLoader
+   */
+  void enable (const std::string &_directory, GLADloadproc load)
+  {
+    GLint formats = 0;
+
+    gl_ext_load(load);
+    if (gl_ext().ARB_get_program_binary)
+    {
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+
+    if (formats == 0)
+    {
+      std::cout << "WARNING::PROGRAM_CACHE::BINARIES_NOT_SUPPORTED" << std::endl;
+      return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(_directory, error);
+    if (error)
+    {
+      std::cout << "WARNING::PROGRAM_CACHE::CANNOT_CREATE_DIRECTORY " << _directory << std::endl;
+      return;
+    }
+
+    directory = _directory;
+    driverHash = hash(glGetString(GL_VENDOR));
+    driverHash = hash(glGetString(GL_RENDERER), driverHash);
+    driverHash = hash(glGetString(GL_VERSION), driverHash);
+    enabled = true;
+  }
+
+  bool isEnabled () const
+  {
+    return enabled;
+  }
+
+  /**
+   * @brief Computes the cache key of a program.
+   *
+   * @param sources (text, length) of every stage, in a fixed order
+   */
+  uint64_t key (std::initializer_list<std::pair<const char *, size_t>> sources) const
+  {
+    uint64_t result = driverHash;
+
+    for (const auto &source : sources)
+    {
+      // Mix in the length so ("ab", "c") and ("a", "bc") differ
+      uint64_t length = source.second;
+      result = hash(&length, sizeof(length), result);
+      result = hash(source.first, source.second, result);
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Tries to load a program from the cache.
+   *
+   * @param program a program object created with glCreateProgram
+   *
+   * @param key the key returned by key()
+   *
+   * @return true if the program is now linked and ready to use
+   */
+  bool load (GLuint program, uint64_t key)
+  {
+    if (!enabled)
+    {
+      return false;
+    }
+
+    // Programs may be built from a hot reload thread too
+    std::lock_guard<std::mutex> lock(mutex);
+    double start = now();
+    Header header;
+    std::vector<char> binary;
+    std::ifstream file(path(key), std::ios::binary);
+
+    if (!file.read((char *)&header, sizeof(header)) || header.magic != MAGIC || header.key != key)
+    {
+      stats.misses++;
+      return false;
+    }
+
+    binary.resize(header.length);
+    if (!file.read(binary.data(), binary.size()))
+    {
+      stats.misses++;
+      return false;
+    }
+
+    GLint success = 0;
+    gl_ext().ProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+    if (!success)
+    {
+      stats.rejected++;
+      stats.misses++;
+      return false;
+    }
+
+    double elapsed = now() - start;
+    stats.hits++;
+    stats.loadSeconds += elapsed;
+    stats.savedSeconds += header.compileSeconds - elapsed;
+
+    return true;
+  }
+
+  /**
+   * @brief Must be called before linking a program that will be stored.
+   *
+   * Hints the driver to keep the binary around after linking.
+   */
+  void prepare (GLuint program) const
+  {
+    if (enabled)
+    {
+      gl_ext().ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+  }
+
+  /**
+   * @brief Stores a freshly linked program.
+   *
+   * @param compileSeconds time spent compiling and linking the program,
+   *   reported later as time saved when the entry is hit
+   */
+  void store (GLuint program, uint64_t key, double compileSeconds)
+  {
+    if (!enabled)
+    {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.compileSeconds += compileSeconds;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+      return;
+    }
+
+    Header header;
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+
+    gl_ext().GetProgramBinary(program, length, &written, &header.format, binary.data());
+
+    header.key = key;
+    header.length = (uint32_t)written;
+    header.compileSeconds = compileSeconds;
+
+    // Write to a temporary file first, so a crash never leaves a torn entry
+    std::string target = path(key);
+    std::string temporary = target + ".tmp";
+    {
+      std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+      file.write((const char *)&header, sizeof(header));
+      file.write(binary.data(), written);
+
+      if (!file)
+      {
+        std::cout << "WARNING::PROGRAM_CACHE::CANNOT_WRITE " << temporary << std::endl;
+        return;
+      }
+    }
+    std::rename(temporary.c_str(), target.c_str());
+  }
+
+  const Stats &getStats () const
+  {
+    return stats;
+  }
+
+  /**
+   * @brief Prints the hit/miss counts and the time saved.
+   */
+  void report () const
+  {
+    if (!enabled)
+    {
+      return;
+    }
+
+    std::cout << "Program cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+              << stats.rejected << " rejected by the driver)" << std::endl;
+    std::cout << "  compile time: " << stats.compileSeconds * 1000.0 << " ms, load time: "
+              << stats.loadSeconds * 1000.0 << " ms, saved: " << stats.savedSeconds * 1000.0 << " ms" << std::endl;
+  }
+
+  static double now ()
+  {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+  }
+
+private:
+  static const uint32_t MAGIC = 0x4250474c; // "LGPB"
+
+  struct Header
+  {
+    uint32_t magic = MAGIC;
+    GLenum format = 0;
+    uint64_t key = 0;
+    uint32_t length = 0;
+    double compileSeconds = 0.0;
+  };
+
+  ProgramCache () {}
+
+  static uint64_t hash (const void *data, size_t size, uint64_t seed = 14695981039346656037ull)
+  {
+    const unsigned char *bytes = (const unsigned char *)data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+      seed ^= bytes[i];
+      seed *= 1099511628211ull;
+    }
+
+    return seed;
+  }
+
+  static uint64_t hash (const GLubyte *text, uint64_t seed = 14695981039346656037ull)
+  {
+    return text ? hash(text, strlen((const char *)text) + 1, seed) : seed;
+  }
+
+  std::string path (uint64_t key) const
+  {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return (std::filesystem::path(directory) / name).string();
+  }
+
+  std::mutex mutex;
+  bool enabled = false;
+  std::string directory;
+  uint64_t driverHash = 0;
+  Stats stats;
+};
+
+#endif
@@ -0,0 +1,473 @@
+#ifndef SHADER_HOT_RELOAD_H
+#define SHADER_HOT_RELOAD_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu_tracer.h"
+#include "shader_preprocessor.h"
+#include "shader_s.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Rebuilds shaders when their files change on disk.
+ *
+ * A background thread blocks on inotify (Linux only, elsewhere the class
+ * does nothing), so there is no polling of any kind. When a watched file
+ * or any file it includes changes, only the programs that use it are
+ * rebuilt. A broken edit keeps the old program and prints the compile
+ * error.
+ *
+ * Programs are compiled on the background thread when it was given a GL
+ * context sharing objects with the main one (e.g. a hidden GLFW window);
+ * otherwise they are compiled on the main thread inside apply(). Either
+ * way the new program only replaces the old one in apply(), which the
+ * render loop calls between frames. When nothing changed apply() is a
+ * single atomic load.
+ *
+ * With a shared context, call stop() before destroying that context or
+ * terminating GLFW: it joins the thread, which releases the context
+ * before it exits.
+ */
+class ShaderHotReload
+{
+public:
+  /**
+   * @brief Starts the watcher thread.
+   *
+   * @param _makeContextCurrent called once on the watcher thread to make
+   *   a shared GL context current there. Leave empty to compile on the
+   *   main thread instead.
+   *
+   * @param _releaseContext called on the watcher thread right before it
+   *   exits, to make no context current there any more
+   */
+  explicit ShaderHotReload (std::function<void()> _makeContextCurrent = std::function<void()>(),
+                            std::function<void()> _releaseContext = std::function<void()>()) :
+  makeContextCurrent(_makeContextCurrent), releaseContext(_releaseContext)
+  {
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (inotifyFd < 0 || wakeFd < 0)
+    {
+      std::cout << "WARNING::HOT_RELOAD::INOTIFY_UNAVAILABLE" << std::endl;
+      return;
+    }
+
+    worker = std::thread([this] () { run(); });
+#endif
+  }
+
+  ~ShaderHotReload ()
+  {
+    stop();
+
+#ifdef __linux__
+    if (inotifyFd >= 0)
+    {
+      close(inotifyFd);
+    }
+    if (wakeFd >= 0)
+    {
+      close(wakeFd);
+    }
+#endif
+  }
+
+  ShaderHotReload (const ShaderHotReload &) = delete;
+  ShaderHotReload &operator= (const ShaderHotReload &) = delete;
+
+  /**
+   * @brief Stops the watcher thread and waits for it to exit. Files are
+   * no longer watched afterwards; apply() still swaps in what was
+   * rebuilt before.
+   */
+  void stop ()
+  {
+#ifdef __linux__
+    if (worker.joinable())
+    {
+      uint64_t one = 1;
+      stopping = true;
+      (void)!write(wakeFd, &one, sizeof(one));
+      worker.join();
+    }
+#endif
+  }
+
+  /**
+   * @brief Starts watching the files of a shader.
+   *
+   * The shader must outlive the watch (or be unwatched first).
+   *
+   * @param defines the same defines the shader was built with, if any
+   */
+  void watch (Shader &shader, const std::string &vertexPath, const std::string &fragmentPath, const std::string &defines = "")
+  {
+    Watched watched;
+
+    watched.shader = &shader;
+    watched.vertexPath = ShaderPreprocessor::normalize(vertexPath);
+    watched.fragmentPath = ShaderPreprocessor::normalize(fragmentPath);
+    watched.defines = defines;
+    watched.files = dependencies(watched);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    shaders.push_back(watched);
+    addWatches(watched.files);
+  }
+
+  /**
+   * @brief Stops watching a shader, e.g. before deleting it.
+   */
+  void unwatch (Shader &shader)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (size_t i = 0; i < shaders.size(); i++)
+    {
+      if (shaders[i].shader == &shader)
+      {
+        shaders.erase(shaders.begin() + i);
+        break;
+      }
+    }
+
+    for (size_t i = 0; i < rebuilds.size(); )
+    {
+      if (rebuilds[i].shader == &shader)
+      {
+        rebuilds.erase(rebuilds.begin() + i);
+      }
+      else
+      {
+        i++;
+      }
+    }
+
+    for (size_t i = 0; i < swaps.size(); )
+    {
+      if (swaps[i].shader == &shader)
+      {
+        glDeleteProgram(swaps[i].program);
+        swaps.erase(swaps.begin() + i);
+      }
+      else
+      {
+        i++;
+      }
+    }
+  }
+
+  /**
+   * @brief Swaps in the programs rebuilt since the previous call.
+   *
+   * Call once per frame from the thread that owns the GL context, outside
+   * of any draw sequence.
+   *
+   * @return the number of shaders that were replaced
+   */
+  unsigned int apply ()
+  {
+    if (!pending.load(std::memory_order_acquire))
+    {
+      return 0;
+    }
+
+    PROFILE_CPU("ShaderHotReload::apply");
+    std::vector<Swap> ready;
+    std::vector<Watched> rebuild;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ready.swap(swaps);
+      rebuild.swap(rebuilds);
+      pending = false;
+    }
+
+    // No shared context: compile here, only for the affected programs
+    for (const Watched &watched : rebuild)
+    {
+      unsigned int program = build(watched);
+      if (program)
+      {
+        ready.push_back(Swap{watched.shader, program});
+      }
+    }
+
+    for (const Swap &swap : ready)
+    {
+      swap.shader->replace(swap.program);
+      std::cout << "Shader " << swap.program << " reloaded" << std::endl;
+    }
+
+    return (unsigned int)ready.size();
+  }
+
+private:
+  struct Watched
+  {
+    Shader *shader;
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::string defines;
+    std::vector<std::string> files;
+  };
+
+  struct Swap
+  {
+    Shader *shader;
+    unsigned int program;
+  };
+
+  // Must be called with the mutex held
+  bool isWatched (const Shader *shader) const
+  {
+    for (const Watched &watched : shaders)
+    {
+      if (watched.shader == shader)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The vertex and fragment files plus everything they include
+  static std::vector<std::string> dependencies (const Watched &watched)
+  {
+    std::vector<std::string> files = {watched.vertexPath, watched.fragmentPath};
+
+    for (const std::string &path : {watched.vertexPath, watched.fragmentPath})
+    {
+      ShaderSource source(path.c_str());
+      ShaderPreprocessor::instance().process(path, source, &files);
+    }
+
+    return files;
+  }
+
+  // Builds a new program, returns 0 (keeping the old one) on failure
+  static unsigned int build (const Watched &watched)
+  {
+    Shader shader(watched.vertexPath.c_str(), watched.fragmentPath.c_str(), watched.defines);
+
+    if (!shader.isLinked())
+    {
+      std::cout << "Reload of " << watched.vertexPath << " + " << watched.fragmentPath
+                << " failed, keeping the previous program" << std::endl;
+      shader.clear();
+      return 0;
+    }
+
+    return shader.ID;
+  }
+
+#ifdef __linux__
+  // Must be called with the mutex held
+  void addWatches (const std::vector<std::string> &files)
+  {
+    for (const std::string &file : files)
+    {
+      // Watch directories: editors often save by renaming a new file over
+      // the old one, which a watch on the file itself would miss
+      std::string::size_type slash = file.rfind('/');
+      std::string directory = slash == std::string::npos ? "." : file.substr(0, slash);
+
+      if (directories.insert(directory).second && inotifyFd >= 0)
+      {
+        int wd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+        if (wd >= 0)
+        {
+          if ((size_t)wd >= watchedDirectories.size())
+          {
+            watchedDirectories.resize(wd + 1);
+          }
+          watchedDirectories[wd] = slash == std::string::npos ? "" : directory + "/";
+        }
+      }
+    }
+  }
+
+  void run ()
+  {
+    bool hasContext = (bool)makeContextCurrent;
+
+    PROFILE_CPU_THREAD("shader-reload");
+    if (hasContext)
+    {
+      makeContextCurrent();
+    }
+
+    while (!stopping)
+    {
+      std::set<std::string> changed;
+
+      if (!waitForChanges(changed, -1))
+      {
+        continue;
+      }
+
+      // Editors emit bursts of events for one save, gather them all
+      while (waitForChanges(changed, 50)) {}
+
+      if (stopping)
+      {
+        break;
+      }
+
+      rebuildAffected(changed, hasContext);
+    }
+
+    if (hasContext && releaseContext)
+    {
+      releaseContext();
+    }
+  }
+
+  // Blocks up to timeout ms; returns true if some file changed
+  bool waitForChanges (std::set<std::string> &changed, int timeout)
+  {
+    struct pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+
+    if (poll(fds, 2, timeout) <= 0 || stopping || !(fds[0].revents & POLLIN))
+    {
+      return false;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t length;
+    bool any = false;
+
+    while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      for (char *cursor = buffer; cursor < buffer + length; )
+      {
+        struct inotify_event *event = (struct inotify_event *)cursor;
+
+        if (event->len > 0 && (size_t)event->wd < watchedDirectories.size())
+        {
+          changed.insert(ShaderPreprocessor::normalize(watchedDirectories[event->wd] + event->name));
+          any = true;
+        }
+
+        cursor += sizeof(struct inotify_event) + event->len;
+      }
+    }
+
+    return any;
+  }
+
+  void rebuildAffected (const std::set<std::string> &changed, bool hasContext)
+  {
+    PROFILE_CPU("ShaderHotReload::rebuild");
+    std::vector<Watched> affected;
+
+    for (const std::string &file : changed)
+    {
+      ShaderPreprocessor::instance().invalidate(file);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      for (const Watched &watched : shaders)
+      {
+        for (const std::string &file : watched.files)
+        {
+          if (changed.count(file))
+          {
+            affected.push_back(watched);
+            break;
+          }
+        }
+      }
+    }
+
+    for (Watched &watched : affected)
+    {
+      // An edit may add or remove includes
+      std::vector<std::string> files = dependencies(watched);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      for (Watched &current : shaders)
+      {
+        if (current.shader == watched.shader)
+        {
+          current.files = files;
+        }
+      }
+      addWatches(files);
+
+      if (!hasContext)
+      {
+        rebuilds.push_back(watched);
+        pending = true;
+      }
+    }
+
+    if (!hasContext)
+    {
+      return;
+    }
+
+    for (const Watched &watched : affected)
+    {
+      unsigned int program = build(watched);
+
+      if (program)
+      {
+        // The main context must see a complete program
+        glFinish();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!isWatched(watched.shader))
+        {
+          // Unwatched while it was being rebuilt
+          glDeleteProgram(program);
+          continue;
+        }
+        swaps.push_back(Swap{watched.shader, program});
+        pending.store(true, std::memory_order_release);
+      }
+    }
+  }
+
+  int inotifyFd = -1;
+  int wakeFd = -1;
+  std::thread worker;
+  std::set<std::string> directories;
+  std::vector<std::string> watchedDirectories;
+#else
+  void addWatches (const std::vector<std::string> &files) {}
+#endif
+
+  std::function<void()> makeContextCurrent;
+  std::function<void()> releaseContext;
+  std::mutex mutex;
+  std::atomic<bool> pending{false};
+  std::atomic<bool> stopping{false};
+  std::vector<Watched> shaders;
+  std::vector<Watched> rebuilds;
+  std::vector<Swap> swaps;
+};
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef SHADER_LIBRARY_H
+#define SHADER_LIBRARY_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gl_ext.h"
+#include "program_cache.h"
+#include "shader_preprocessor.h"
+#include "shader_s.h"
+#include "shader_source.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Builds many shader programs without stalling the render loop.
+ *
+ * Shader files are read concurrently on a pool of worker threads. As
+ * soon as both sources of a program are available, update() (called
+ * from the thread that owns the GL context) submits the compile and link
+ * of every program in one go, without asking for their status. Status
+ * is only queried later: with GL_KHR_parallel_shader_compile through the
+ * non-blocking GL_COMPLETION_STATUS_KHR, otherwise one update() after
+ * submission, so the driver can overlap the work of all programs.
+ *
+ * Each request returns a ShaderHandle that the render loop can poll,
+ * drawing with a fallback until the program is ready.
+ */
+class ShaderLibrary
+{
+public:
+  enum State
+  {
+    READING,
+    COMPILING,
+    READY,
+    FAILED
+  };
+
+  struct Entry
+  {
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::future<ShaderSource> vertexSource;
+    std::future<ShaderSource> fragmentSource;
+    uint64_t key = 0;
+
+    State state = READING;
+    unsigned int program = 0;
+    unsigned int vertex = 0;
+    unsigned int fragment = 0;
+    double submitted = 0.0;
+    unsigned int updatesSinceSubmit = 0;
+    std::unique_ptr<Shader> shader;
+  };
+
+  /**
+   * @brief Future-like reference to a program built by the library.
+   */
+  class ShaderHandle
+  {
+  public:
+    ShaderHandle () {}
+
+    explicit ShaderHandle (std::shared_ptr<Entry> _entry) : entry(_entry) {}
+
+    bool isReady () const
+    {
+      return entry && entry->state == READY;
+    }
+
+    bool failed () const
+    {
+      return entry && entry->state == FAILED;
+    }
+
+    // Only valid once isReady() returns true
+    Shader &get () const
+    {
+      return *entry->shader;
+    }
+
+  private:
+    std::shared_ptr<Entry> entry;
+  };
+
+  /**
+   * @brief Creates the library and its file reading workers.
+   *
+   * Must be called with the GL context current.
+   *
+   * @param load the loader given to gladLoadGLLoader, used to look for
+   *   GL_KHR_parallel_shader_compile
+   *
+   * @param threads number of file reading workers
+   */
+  ShaderLibrary (GLADloadproc load, unsigned int threads = 2) : pool(threads)
+  {
+    gl_ext_load(load);
+
+    if (gl_ext().KHR_parallel_shader_compile)
+    {
+      // Let the driver pick as many compiler threads as it wants
+      gl_ext().MaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+    }
+  }
+
+  /**
+   * @brief Requests a program. Returns immediately.
+   *
+   * @param vertexPath path to the vertex shader source
+   *
+   * @param fragmentPath path to the fragment shader source
+   *
+   * @param defines "#define KEY VALUE" lines inserted after #version in
+   *   both stages, like the Shader constructor does
+   */
+  ShaderHandle load (const std::string &vertexPath, const std::string &fragmentPath, const std::string &defines = "")
+  {
+    auto entry = std::make_shared<Entry>();
+
+    entry->vertexPath = vertexPath;
+    entry->fragmentPath = fragmentPath;
+    entry->vertexSource = pool.submit([vertexPath, defines] () { return read(vertexPath, defines); });
+    entry->fragmentSource = pool.submit([fragmentPath, defines] () { return read(fragmentPath, defines); });
+
+    entries.push_back(entry);
+
+    return ShaderHandle(entry);
+  }
+
+  /**
+   * @brief Advances every pending program. Call once per frame.
+   *
+   * Never blocks on the driver when GL_KHR_parallel_shader_compile is
+   * available.
+   *
+   * @return the number of programs still pending
+   */
+  unsigned int update ()
+  {
+    unsigned int pending = 0;
+
+    // First submit everything that can be submitted...
+    for (auto &entry : entries)
+    {
+      if (entry->state == READING && sourcesReady(*entry))
+      {
+        submit(*entry);
+      }
+    }
+
+    // ...then look at the programs submitted in previous calls
+    for (auto &entry : entries)
+    {
+      if (entry->state == COMPILING && entry->updatesSinceSubmit++ > 0)
+      {
+        poll(*entry);
+      }
+
+      pending += entry->state == READING || entry->state == COMPILING;
+    }
+
+    return pending;
+  }
+
+  /**
+   * @brief Blocks until every requested program is ready or failed.
+   */
+  void wait ()
+  {
+    while (update() > 0)
+    {
+      for (auto &entry : entries)
+      {
+        if (entry->state == READING)
+        {
+          entry->vertexSource.wait();
+          entry->fragmentSource.wait();
+        }
+        else if (entry->state == COMPILING)
+        {
+          // Blocking query, the driver finishes the program here
+          finish(*entry);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Deletes every program built by the library.
+   */
+  void clear ()
+  {
+    for (auto &entry : entries)
+    {
+      if (entry->program)
+      {
+        glDeleteProgram(entry->program);
+        entry->program = 0;
+      }
+    }
+    entries.clear();
+  }
+
+private:
+  static ShaderSource read (const std::string &path, const std::string &defines)
+  {
+    ShaderSource source(path.c_str());
+    ShaderPreprocessor::instance().process(path, source);
+    ShaderPreprocessor::define(source, defines);
+    return source;
+  }
+
+  static bool sourcesReady (Entry &entry)
+  {
+    return entry.vertexSource.wait_for(std::chrono::seconds(0)) == std::future_status::ready
+      && entry.fragmentSource.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  }
+
+  // Queues compilation and link without querying any status
+  void submit (Entry &entry)
+  {
+    ShaderSource vertexSource = entry.vertexSource.get();
+    ShaderSource fragmentSource = entry.fragmentSource.get();
+    ProgramCache &cache = ProgramCache::instance();
+
+    entry.program = glCreateProgram();
+    entry.submitted = ProgramCache::now();
+
+    if (cache.isEnabled())
+    {
+      entry.key = cache.key({{vertexSource.data(), vertexSource.size()}, {fragmentSource.data(), fragmentSource.size()}});
+
+      if (cache.load(entry.program, entry.key))
+      {
+        entry.shader.reset(new Shader(entry.program));
+        entry.state = READY;
+        return;
+      }
+
+      glDeleteProgram(entry.program);
+      entry.program = glCreateProgram();
+    }
+
+    entry.vertex = glCreateShader(GL_VERTEX_SHADER);
+    vertexSource.upload(entry.vertex);
+    glCompileShader(entry.vertex);
+
+    entry.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    fragmentSource.upload(entry.fragment);
+    glCompileShader(entry.fragment);
+
+    cache.prepare(entry.program);
+    glAttachShader(entry.program, entry.vertex);
+    glAttachShader(entry.program, entry.fragment);
+    glLinkProgram(entry.program);
+
+    entry.state = COMPILING;
+    entry.updatesSinceSubmit = 0;
+  }
+
+  void poll (Entry &entry)
+  {
+    if (gl_ext().KHR_parallel_shader_compile)
+    {
+      GLint done = GL_FALSE;
+      glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &done);
+
+      if (!done)
+      {
+        return;
+      }
+    }
+
+    finish(entry);
+  }
+
+  void finish (Entry &entry)
+  {
+    char infoLog[512];
+    int success;
+
+    glGetProgramiv(entry.program, GL_LINK_STATUS, &success);
+
+    if (!success)
+    {
+      // Report the stage that broke, like the Shader constructor does
+      glGetShaderiv(entry.vertex, GL_COMPILE_STATUS, &success);
+      if (!success)
+      {
+        glGetShaderInfoLog(entry.vertex, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED " << entry.vertexPath << "\n" << infoLog << std::endl;
+        ShaderPreprocessor::instance().printSourceNames();
+      }
+
+      glGetShaderiv(entry.fragment, GL_COMPILE_STATUS, &success);
+      if (!success)
+      {
+        glGetShaderInfoLog(entry.fragment, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED " << entry.fragmentPath << "\n" << infoLog << std::endl;
+        ShaderPreprocessor::instance().printSourceNames();
+      }
+
+      glGetProgramInfoLog(entry.program, 512, NULL, infoLog);
+      std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+
+      entry.state = FAILED;
+    }
+    else
+    {
+      ProgramCache::instance().store(entry.program, entry.key, ProgramCache::now() - entry.submitted);
+      entry.shader.reset(new Shader(entry.program));
+      entry.state = READY;
+    }
+
+    glDeleteShader(entry.vertex);
+    glDeleteShader(entry.fragment);
+    entry.vertex = entry.fragment = 0;
+  }
+
+  ThreadPool pool;
+  std::vector<std::shared_ptr<Entry>> entries;
+};
+
+typedef ShaderLibrary::ShaderHandle ShaderHandle;
+
+#endif
@@ -0,0 +1,440 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "shader_source.h"
+
+/**
+ * @brief Resolves #include directives in GLSL sources.
+ *
+ * Included files ("chunks") are read and split into text runs and
+ * include directives only once; the parsed chunk is cached in memory and
+ * shared by every program that includes it. A chunk is expanded at most
+ * once per program (as if it had #pragma once), so shared chunks need no
+ * manual guards, although #ifndef guards still work.
+ *
+ * Every file gets a source string number, stable for the whole run, and
+ * the expansion emits #line directives so compile errors point at the
+ * original file and line. sourceName() maps the number back to a path.
+ *
+ * Paths in #include "..." are relative to the including file.
+ */
+class ShaderPreprocessor
+{
+public:
+  struct Stats
+  {
+    unsigned int chunksParsed = 0;
+    unsigned int chunkHits = 0;
+    size_t bytesRead = 0;
+  };
+
+  static ShaderPreprocessor &instance ()
+  {
+    static ShaderPreprocessor preprocessor;
+    return preprocessor;
+  }
+
+  /**
+   * @brief Expands the includes of a source in place.
+   *
+   * Sources without #include are left untouched (and keep pointing at
+   * the file mapping). Safe to call from several threads.
+   *
+   * @param path path of the source, used to resolve relative includes
+   *
+   * @param source the source text, replaced by its expansion
+   *
+   * @param dependencies if given, receives the (normalized) paths of
+   *   every file included directly or indirectly
+   *
+   * @return false if an included file could not be read
+   */
+  bool process (const std::string &path, ShaderSource &source, std::vector<std::string> *dependencies = NULL)
+  {
+    if (!hasInclude(source.data(), source.size()))
+    {
+      return true;
+    }
+
+    std::shared_ptr<const Chunk> root = parse(path, source.data(), source.size());
+    std::set<std::string> included;
+    std::string output;
+    bool success = true;
+
+    included.insert(root->path);
+    output.reserve(source.size() * 2);
+    expand(*root, included, output, success);
+
+    if (dependencies)
+    {
+      for (const std::string &file : included)
+      {
+        if (file != root->path)
+        {
+          dependencies->push_back(file);
+        }
+      }
+    }
+
+    source.assign(std::move(output));
+    return success;
+  }
+
+  /**
+   * @brief Inserts #define lines right after the #version line.
+   *
+   * A #line directive follows them, so line numbers in compile errors
+   * still match the file.
+   *
+   * @param source the (already preprocessed) source text
+   *
+   * @param defines block of "#define KEY VALUE" lines
+   */
+  static void define (ShaderSource &source, const std::string &defines)
+  {
+    if (defines.empty())
+    {
+      return;
+    }
+
+    std::string text(source.data(), source.size());
+    std::string::size_type split = 0;
+
+    if (text.compare(0, 8, "#version") == 0)
+    {
+      split = text.find('\n');
+      split = split == std::string::npos ? text.size() : split + 1;
+    }
+
+    std::string line = split ? "#line 2\n" : "#line 1\n";
+    text.insert(split, defines + line);
+    source.assign(text);
+  }
+
+  /**
+   * @brief Returns the path of a source string number used in #line.
+   */
+  std::string sourceName (int id)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return id >= 0 && id < (int)names.size() ? names[id] : std::string("?");
+  }
+
+  /**
+   * @brief Prints the source string numbers, to decode compile errors.
+   */
+  void printSourceNames ()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+      std::cout << "  source " << i << ": " << names[i] << std::endl;
+    }
+  }
+
+  /**
+   * @brief Drops every cached chunk, e.g. after a file changed on disk.
+   */
+  void clear ()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    chunks.clear();
+  }
+
+  /**
+   * @brief Drops one cached chunk.
+   */
+  void invalidate (const std::string &path)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    chunks.erase(normalize(path));
+  }
+
+  /**
+   * @brief Removes "." and "a/.." parts, so one file has one name.
+   */
+  static std::string normalize (const std::string &path)
+  {
+    std::vector<std::string> parts;
+    std::string part;
+    std::string result = path.size() && path[0] == '/' ? "/" : "";
+
+    for (size_t i = 0; i <= path.size(); i++)
+    {
+      if (i == path.size() || path[i] == '/')
+      {
+        if (part == ".." && !parts.empty() && parts.back() != "..")
+        {
+          parts.pop_back();
+        }
+        else if (!part.empty() && part != ".")
+        {
+          parts.push_back(part);
+        }
+        part.clear();
+      }
+      else
+      {
+        part += path[i];
+      }
+    }
+
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+      result += (i ? "/" : "") + parts[i];
+    }
+
+    return result;
+  }
+
+  Stats getStats ()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+  }
+
+private:
+  struct Segment
+  {
+    // Either a run of lines, or an include directive
+    bool include;
+    std::string text;
+    int line;
+  };
+
+  struct Chunk
+  {
+    std::string path;
+    int id;
+    std::vector<Segment> segments;
+  };
+
+  ShaderPreprocessor () {}
+
+  static bool hasInclude (const char *text, size_t size)
+  {
+    static const char directive[] = "#include";
+    const size_t length = sizeof(directive) - 1;
+
+    for (size_t i = 0; i + length <= size; i++)
+    {
+      if (text[i] == '#' && memcmp(text + i, directive, length) == 0)
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  static std::string directory (const std::string &path)
+  {
+    std::string::size_type slash = path.rfind('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+  }
+
+  // Returns the quoted path if the line is an #include directive
+  static bool parseInclude (const char *begin, const char *end, std::string &target)
+  {
+    while (begin < end && (*begin == ' ' || *begin == '\t'))
+    {
+      begin++;
+    }
+
+    if (end - begin < 8 || memcmp(begin, "#include", 8) != 0)
+    {
+      return false;
+    }
+    begin += 8;
+
+    while (begin < end && (*begin == ' ' || *begin == '\t'))
+    {
+      begin++;
+    }
+
+    if (begin == end || (*begin != '"' && *begin != '<'))
+    {
+      return false;
+    }
+
+    char close = *begin == '"' ? '"' : '>';
+    const char *stop = (const char *)memchr(begin + 1, close, end - begin - 1);
+
+    if (!stop)
+    {
+      return false;
+    }
+
+    target.assign(begin + 1, stop);
+    return true;
+  }
+
+  int idOf (const std::string &path)
+  {
+    for (size_t i = 0; i < names.size(); i++)
+    {
+      if (names[i] == path)
+      {
+        return (int)i;
+      }
+    }
+
+    names.push_back(path);
+    return (int)names.size() - 1;
+  }
+
+  std::shared_ptr<const Chunk> parse (const std::string &rawPath, const char *text, size_t size)
+  {
+    auto chunk = std::make_shared<Chunk>();
+    const char *end = text + size;
+    int line = 1;
+
+    chunk->path = normalize(rawPath);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      chunk->id = idOf(chunk->path);
+    }
+
+    for (const char *cursor = text; cursor < end; line++)
+    {
+      const char *newline = (const char *)memchr(cursor, '\n', end - cursor);
+      const char *lineEnd = newline ? newline + 1 : end;
+      std::string target;
+
+      if (parseInclude(cursor, lineEnd, target))
+      {
+        chunk->segments.push_back(Segment{true, normalize(directory(chunk->path) + target), line});
+      }
+      else
+      {
+        if (chunk->segments.empty() || chunk->segments.back().include)
+        {
+          chunk->segments.push_back(Segment{false, std::string(), line});
+        }
+        chunk->segments.back().text.append(cursor, lineEnd);
+      }
+
+      cursor = lineEnd;
+    }
+
+    // Make sure the last line is terminated before the next segment
+    if (!chunk->segments.empty() && !chunk->segments.back().include)
+    {
+      std::string &last = chunk->segments.back().text;
+      if (!last.empty() && last.back() != '\n')
+      {
+        last += '\n';
+      }
+    }
+
+    return chunk;
+  }
+
+  // Returns the cached chunk of a file, reading and parsing it if needed
+  std::shared_ptr<const Chunk> load (const std::string &path)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found = chunks.find(path);
+
+      if (found != chunks.end())
+      {
+        stats.chunkHits++;
+        return found->second;
+      }
+    }
+
+    ShaderSource source;
+    if (!source.open(path.c_str()))
+    {
+      return nullptr;
+    }
+
+    std::shared_ptr<const Chunk> chunk = parse(path, source.data(), source.size());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.chunksParsed++;
+    stats.bytesRead += source.size();
+    chunks[path] = chunk;
+
+    return chunk;
+  }
+
+  void expand (const Chunk &chunk, std::set<std::string> &included, std::string &output, bool &success)
+  {
+    bool resume = true;
+
+    for (const Segment &segment : chunk.segments)
+    {
+      if (!segment.include)
+      {
+        const std::string &text = segment.text;
+        size_t skip = 0;
+
+        // #version has to stay the very first line of the program, and is
+        // dropped from included chunks
+        if (segment.line == 1 && text.compare(0, 8, "#version") == 0)
+        {
+          skip = text.find('\n') + 1;
+          if (output.empty())
+          {
+            output.append(text, 0, skip);
+          }
+          resume = true;
+        }
+
+        if (skip == text.size())
+        {
+          continue;
+        }
+
+        if (resume)
+        {
+          int line = segment.line + (skip ? 1 : 0);
+          output += "#line " + std::to_string(line) + " " + std::to_string(chunk.id) + "\n";
+          resume = false;
+        }
+
+        output.append(text, skip, std::string::npos);
+        continue;
+      }
+
+      if (!included.insert(segment.text).second)
+      {
+        // Already expanded in this program, the directive becomes a blank line
+        output += "\n";
+        continue;
+      }
+
+      std::shared_ptr<const Chunk> child = load(segment.text);
+      if (!child)
+      {
+        std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND " << segment.text
+                  << " (" << chunk.path << ":" << segment.line << ")" << std::endl;
+        success = false;
+        resume = true;
+        continue;
+      }
+
+      expand(*child, included, output, success);
+      resume = true;
+    }
+  }
+
+  std::mutex mutex;
+  std::map<std::string, std::shared_ptr<const Chunk>> chunks;
+  std::vector<std::string> names;
+  Stats stats;
+};
+
+#endif
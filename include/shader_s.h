@@ -5,9 +5,15 @@
 #include <glm/glm.hpp>
 
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
+#include <utility>
+#include <vector>
+
+#include "gl_state.h"
+#include "program_cache.h"
+#include "shader_preprocessor.h"
+#include "shader_source.h"
+#include "uniform_cache.h"
 
 class Shader
 {
@@ -15,163 +21,258 @@ class Shader
     // The program ID
     unsigned int ID;
 
-    // Constructor reads and builds the shader
-    Shader (const char *vertexPath, const char *fragmentPath)
+    // Constructor reads and builds the shader. The optional defines
+    // ("#define KEY VALUE" lines) are inserted after #version in both
+    // stages, see ShaderVariants.
+    Shader (const char *vertexPath, const char *fragmentPath, const std::string &defines = "")
     {
-      const char *vShaderCode;
-      const char *fShaderCode;
-      char infoLog[512];
-      int success;
-      unsigned int vertex, fragment;
-      std::string vertexCode;
-      std::string fragmentCode;
-      std::ifstream vShaderFile;
-      std::ifstream fShaderFile;
-      std::stringstream vShaderStream, fShaderStream;
-
-      // Ensure ifstream objects can throw exceptions
-      vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-      fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-      // 1. Retrieve the shaders' source code from paths
-      try
-      {
-        // Open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-
-        // Read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
+      // 1. Map the shaders' source code from paths. The text is handed to
+      // the driver straight from the mapping, without intermediate copies
+      ShaderSource vertexSource(vertexPath);
+      ShaderSource fragmentSource(fragmentPath);
 
-        // Close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
+      // Resolve #include directives (shared chunks are parsed only once)
+      ShaderPreprocessor::instance().process(vertexPath, vertexSource);
+      ShaderPreprocessor::instance().process(fragmentPath, fragmentSource);
+      ShaderPreprocessor::define(vertexSource, defines);
+      ShaderPreprocessor::define(fragmentSource, defines);
 
-        // Convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+      // 2. Reuse the linked binary from a previous run if there is one
+      ProgramCache &cache = ProgramCache::instance();
+      uint64_t key = cache.isEnabled() ? cache.key({{vertexSource.data(), vertexSource.size()}, {fragmentSource.data(), fragmentSource.size()}}) : 0;
 
-        vShaderCode = vertexCode.c_str();
-        fShaderCode = fragmentCode.c_str();
-      }
-      catch (std::ifstream::failure e)
+      ID = glCreateProgram();
+      if (cache.load(ID, key))
       {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+        linked = true;
+        uniforms.build(ID);
+        return;
       }
 
-      // Vertex shader
-      vertex = glCreateShader(GL_VERTEX_SHADER);
-      glShaderSource(vertex, 1, &vShaderCode, NULL);
-      glCompileShader(vertex);
-      glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-
-      if (!success)
+      if (cache.isEnabled())
       {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        // A rejected binary leaves the program in a failed state
+        glDeleteProgram(ID);
+        ID = glCreateProgram();
       }
 
-      // Fragment shader
-      fragment = glCreateShader(GL_FRAGMENT_SHADER);
-      glShaderSource(fragment, 1, &fShaderCode, NULL);
-      glCompileShader(fragment);
-      glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-
-      if (!success)
+      // 3. Compile and link from source
+      double start = ProgramCache::now();
+      if (build(vertexSource, fragmentSource))
       {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        linked = true;
+        cache.store(ID, key, ProgramCache::now() - start);
+
+        // Resolve every uniform location once, so set* never asks the driver
+        uniforms.build(ID);
       }
+    }
 
-      // Shader program
-      ID = glCreateProgram();
-      glAttachShader(ID, vertex);
-      glAttachShader(ID, fragment);
-      glLinkProgram(ID);
+    // Adopts an already linked program, e.g. one built by ShaderLibrary
+    explicit Shader (unsigned int program) : ID(program)
+    {
+      int success = 0;
       glGetProgramiv(ID, GL_LINK_STATUS, &success);
 
-      if (!success)
+      linked = success;
+      uniforms.build(ID);
+    }
+
+    bool isLinked () const
+    {
+      return linked;
+    }
+
+    /**
+     * Swaps in a freshly linked program (e.g. after a hot reload) and
+     * deletes the old one. The current uniform values are carried over,
+     * so values set once at startup survive the swap.
+     */
+    void replace (unsigned int program)
+    {
+      UniformCache::copyValues(ID, program);
+      glDeleteProgram(ID);
+      GLState::instance().deleted(ID);
+
+      ID = program;
+      linked = true;
+      uniforms.build(ID);
+
+      // Block bindings are program state, set them again on the new one
+      for (const auto &block : blocks)
       {
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        bindBlock(block.first.c_str(), block.second);
       }
+    }
 
-      // Delete the shaders as they're linked into our program now
-      glDeleteShader(vertex);
-      glDeleteShader(fragment);
+    /**
+     * Attaches the named uniform block of the program to a binding point,
+     * where a uniform buffer shared by several programs is bound (see
+     * FrameUniforms). Returns false if the program has no such block.
+     */
+    bool bindUniformBlock (const char *name, unsigned int binding)
+    {
+      for (auto &block : blocks)
+      {
+        if (block.first == name)
+        {
+          block.second = binding;
+          return bindBlock(name, binding);
+        }
+      }
+
+      blocks.emplace_back(name, binding);
+      return bindBlock(name, binding);
     }
 
     void clear ()
     {
       glDeleteProgram(ID);
+      GLState::instance().deleted(ID);
     }
 
-    // Use/activate the shader
+    // Use/activate the shader. Skipped when it is already in use
     void use ()
     {
-      glUseProgram(ID);
+      GLState::instance().useProgram(ID);
+    }
+
+    // Location of a uniform, taken from the cache built after linking
+    GLint location (const UniformName &name) const
+    {
+      return uniforms.find(name);
     }
 
     // Utility uniform functions
-    void setBool (const std::string &name, bool value) const
+    void setBool (const UniformName &name, bool value) const
+    {
+      glUniform1i(location(name), (int)value);
+    }
+
+    void setInt (const UniformName &name, int value) const
+    {
+      glUniform1i(location(name), value);
+    }
+
+    void setFloat (const UniformName &name, float value) const
     {
-      glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+      glUniform1f(location(name), value);
     }
 
-    void setInt (const std::string &name, int value) const
+    void setVec2 (const UniformName &name, const glm::vec2 &value) const
     {
-      glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+      glUniform2fv(location(name), 1, &value[0]);
     }
 
-    void setFloat (const std::string &name, float value) const
+    void setVec2 (const UniformName &name, float x, float y) const
     {
-      glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+      glUniform2f(location(name), x, y);
     }
 
-    void setVec2 (const std::string &name, const glm::vec2 &value) const
+    void setVec3 (const UniformName &name, const glm::vec3 &value) const
     {
-      glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+      glUniform3fv(location(name), 1, &value[0]);
     }
 
-    void setVec2 (const std::string &name, float x, float y) const
+    void setVec3 (const UniformName &name, float x, float y, float z) const
     {
-      glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+      glUniform3f(location(name), x, y, z);
     }
 
-    void setVec3 (const std::string &name, const glm::vec3 &value) const
+    void setVec4 (const UniformName &name, const glm::vec4 &value) const
     {
-      glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+      glUniform4fv(location(name), 1, &value[0]);
     }
 
-    void setVec3 (const std::string &name, float x, float y, float z) const
+    void setVec4 (const UniformName &name, float x, float y, float z, float w) const
     {
-      glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+      glUniform4f(location(name), x, y, z, w);
     }
 
-    void setVec4 (const std::string &name, const glm::vec4 &value) const
+    void setMat2 (const UniformName &name, const glm::mat2 &mat) const
     {
-      glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+      glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);      
     }
 
-    void setVec4 (const std::string &name, float x, float y, float z, float w) const
+    void setMat3 (const UniformName &name, const glm::mat3 &mat) const
     {
-      glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+      glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
-    void setMat2 (const std::string &name, const glm::mat2 &mat) const
+    void setMat4 (const UniformName &name, const glm::mat4 &mat) const
     {
-      glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);      
+      glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
-    void setMat3 (const std::string &name, const glm::mat3 &mat) const
+  private:
+    UniformCache uniforms;
+    bool linked = false;
+    std::vector<std::pair<std::string, unsigned int>> blocks;
+
+    bool bindBlock (const char *name, unsigned int binding) const
     {
-      glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+      GLuint index = glGetUniformBlockIndex(ID, name);
+
+      if (index == GL_INVALID_INDEX)
+      {
+        return false;
+      }
+
+      glUniformBlockBinding(ID, index, binding);
+      return true;
     }
 
-    void setMat4 (const std::string &name, const glm::mat4 &mat) const
+    // Compiles both stages and links them into ID. Returns the link status.
+    bool build (const ShaderSource &vertexSource, const ShaderSource &fragmentSource)
     {
-      glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+      char infoLog[512];
+      int success;
+      unsigned int vertex, fragment;
+
+      // Vertex shader
+      vertex = glCreateShader(GL_VERTEX_SHADER);
+      vertexSource.upload(vertex);
+      glCompileShader(vertex);
+      glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+
+      if (!success)
+      {
+        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        ShaderPreprocessor::instance().printSourceNames();
+      }
+
+      // Fragment shader
+      fragment = glCreateShader(GL_FRAGMENT_SHADER);
+      fragmentSource.upload(fragment);
+      glCompileShader(fragment);
+      glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+
+      if (!success)
+      {
+        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        ShaderPreprocessor::instance().printSourceNames();
+      }
+
+      // Shader program
+      ProgramCache::instance().prepare(ID);
+      glAttachShader(ID, vertex);
+      glAttachShader(ID, fragment);
+      glLinkProgram(ID);
+      glGetProgramiv(ID, GL_LINK_STATUS, &success);
+
+      if (!success)
+      {
+        glGetProgramInfoLog(ID, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+      }
+
+      // Delete the shaders as they're linked into our program now
+      glDeleteShader(vertex);
+      glDeleteShader(fragment);
+
+      return success;
     }
 };
 
@@ -0,0 +1,221 @@
+#ifndef SHADER_SOURCE_H
+#define SHADER_SOURCE_H
+
+#include <glad/glad.h>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SHADER_SOURCE_MMAP 1
+#endif
+
+/**
+ * @brief Read-only view of a shader file.
+ *
+ * On POSIX systems big files are memory-mapped, so their text goes from
+ * the page cache straight to glShaderSource without any copy. Small ones
+ * (and every file elsewhere) are read with a single sized read into one
+ * buffer: one allocation and one copy per source.
+ *
+ * The text is NOT null-terminated: always pass size() along with data().
+ */
+class ShaderSource
+{
+public:
+  // Below this size a single read beats mmap
+  static const long MMAP_THRESHOLD = 64 * 1024;
+
+  ShaderSource () {}
+
+  explicit ShaderSource (const char *path)
+  {
+    open(path);
+  }
+
+  ~ShaderSource ()
+  {
+    close();
+  }
+
+  ShaderSource (const ShaderSource &) = delete;
+  ShaderSource &operator= (const ShaderSource &) = delete;
+
+  ShaderSource (ShaderSource &&other) noexcept
+  {
+    *this = std::move(other);
+  }
+
+  ShaderSource &operator= (ShaderSource &&other) noexcept
+  {
+    if (this != &other)
+    {
+      close();
+      text = other.text;
+      length = other.length;
+      mapped = other.mapped;
+      valid = other.valid;
+      buffer = std::move(other.buffer);
+      other.text = "";
+      other.length = 0;
+      other.mapped = false;
+      other.valid = false;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Opens a file, releasing the previous one.
+   *
+   * @return false (and prints an error) if the file cannot be read
+   */
+  bool open (const char *path)
+  {
+    close();
+
+#ifdef SHADER_SOURCE_MMAP
+    int fd = ::open(path, O_RDONLY);
+    struct stat info;
+
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+      }
+      return fail(path);
+    }
+
+    // Small files are cheaper to read than to map (mmap + page fault +
+    // munmap cost more than copying a few KB), so only map big ones
+    if (info.st_size >= MMAP_THRESHOLD)
+    {
+      void *address = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (address == MAP_FAILED)
+      {
+        ::close(fd);
+        return fail(path);
+      }
+
+      text = (const char *)address;
+      length = (size_t)info.st_size;
+      mapped = true;
+    }
+    else if (info.st_size > 0)
+    {
+      buffer.resize((size_t)info.st_size);
+
+      if (pread(fd, buffer.data(), buffer.size(), 0) != (ssize_t)buffer.size())
+      {
+        ::close(fd);
+        return fail(path);
+      }
+
+      text = buffer.data();
+      length = buffer.size();
+    }
+
+    ::close(fd);
+#else
+    FILE *file = fopen(path, "rb");
+
+    if (!file)
+    {
+      return fail(path);
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    buffer.resize(size > 0 ? (size_t)size : 0);
+    if (size > 0 && fread(buffer.data(), 1, buffer.size(), file) != buffer.size())
+    {
+      fclose(file);
+      return fail(path);
+    }
+    fclose(file);
+
+    text = buffer.data();
+    length = buffer.size();
+#endif
+
+    valid = true;
+    return true;
+  }
+
+  void close ()
+  {
+#ifdef SHADER_SOURCE_MMAP
+    if (mapped)
+    {
+      munmap((void *)text, length);
+    }
+#endif
+    text = "";
+    length = 0;
+    mapped = false;
+    valid = false;
+    buffer.clear();
+  }
+
+  /**
+   * @brief Replaces the text with an owned copy, e.g. after preprocessing.
+   */
+  void assign (const std::string &text)
+  {
+    close();
+    buffer.assign(text.begin(), text.end());
+    this->text = buffer.data();
+    length = buffer.size();
+    valid = true;
+  }
+
+  bool isOpen () const
+  {
+    return valid;
+  }
+
+  const char *data () const
+  {
+    return text;
+  }
+
+  size_t size () const
+  {
+    return length;
+  }
+
+  /**
+   * @brief Hands the text to a shader object.
+   *
+   * @param shader a shader created with glCreateShader
+   */
+  void upload (unsigned int shader) const
+  {
+    GLint glLength = (GLint)length;
+    glShaderSource(shader, 1, &text, &glLength);
+  }
+
+private:
+  bool fail (const char *path)
+  {
+    std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+    return false;
+  }
+
+  const char *text = "";
+  size_t length = 0;
+  bool mapped = false;
+  bool valid = false;
+  std::vector<char> buffer;
+};
+
+#endif
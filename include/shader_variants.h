@@ -0,0 +1,219 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "program_cache.h"
+#include "shader_hot_reload.h"
+#include "shader_s.h"
+
+/**
+ * @brief Set of compile-time #define key/values selecting a variant.
+ *
+ * Keys are kept sorted, so the same set always produces the same hash
+ * regardless of the order in which the values were given.
+ */
+class ShaderDefines
+{
+public:
+  ShaderDefines () {}
+
+  ShaderDefines (std::initializer_list<std::pair<const std::string, std::string>> values) : values(values) {}
+
+  ShaderDefines &set (const std::string &key, const std::string &value = "1")
+  {
+    values[key] = value;
+    return *this;
+  }
+
+  ShaderDefines &set (const std::string &key, float value)
+  {
+    // Always keep a decimal point, GLSL float literals need it
+    std::string text = std::to_string(value);
+    return set(key, text);
+  }
+
+  ShaderDefines &unset (const std::string &key)
+  {
+    values.erase(key);
+    return *this;
+  }
+
+  /**
+   * @brief 64-bit FNV-1a hash of the sorted key/value pairs.
+   */
+  uint64_t hash () const
+  {
+    uint64_t result = 14695981039346656037ull;
+
+    for (const auto &value : values)
+    {
+      for (const std::string *text : {&value.first, &value.second})
+      {
+        // The trailing '\0' separates the strings, so ("AB","C") != ("A","BC")
+        for (size_t i = 0; i <= text->size(); i++)
+        {
+          result ^= (unsigned char)(*text)[i];
+          result *= 1099511628211ull;
+        }
+      }
+    }
+
+    return result;
+  }
+
+  // "#define KEY VALUE" lines, inserted after #version
+  std::string source () const
+  {
+    std::string text;
+
+    for (const auto &value : values)
+    {
+      text += "#define " + value.first + " " + value.second + "\n";
+    }
+
+    return text;
+  }
+
+  // "KEY=VALUE KEY=VALUE", for reports
+  std::string describe () const
+  {
+    std::string text;
+
+    for (const auto &value : values)
+    {
+      text += (text.empty() ? "" : " ") + value.first + "=" + value.second;
+    }
+
+    return text.empty() ? "(default)" : text;
+  }
+
+private:
+  std::map<std::string, std::string> values;
+};
+
+/**
+ * @brief Compile-time permutations of one vertex/fragment shader pair.
+ *
+ * Each distinct set of defines is built on first use and memoized by the
+ * 64-bit hash of the set, so branches like "specular on/off" cost nothing
+ * at run time: the render loop just picks a different program.
+ */
+class ShaderVariants
+{
+public:
+  ShaderVariants (const std::string &_vertexPath, const std::string &_fragmentPath) :
+  vertexPath(_vertexPath),
+  fragmentPath(_fragmentPath)
+  {}
+
+  ~ShaderVariants ()
+  {
+    clear();
+  }
+
+  ShaderVariants (const ShaderVariants &) = delete;
+  ShaderVariants &operator= (const ShaderVariants &) = delete;
+
+  /**
+   * @brief Returns the variant for a set of defines, building it if needed.
+   */
+  Shader &get (const ShaderDefines &defines)
+  {
+    uint64_t key = defines.hash();
+    auto found = variants.find(key);
+
+    if (found != variants.end())
+    {
+      return *found->second.shader;
+    }
+
+    Variant &variant = variants[key];
+    double start = ProgramCache::now();
+
+    variant.description = defines.describe();
+    variant.shader.reset(new Shader(vertexPath.c_str(), fragmentPath.c_str(), defines.source()));
+    variant.buildSeconds = ProgramCache::now() - start;
+    variant.defines = defines.source();
+
+    if (hotReload)
+    {
+      hotReload->watch(*variant.shader, vertexPath, fragmentPath, variant.defines);
+    }
+
+    return *variant.shader;
+  }
+
+  /**
+   * @brief Rebuilds the variants (built so far and later) when their files
+   * change. The watcher must outlive this object.
+   */
+  void setHotReload (ShaderHotReload *_hotReload)
+  {
+    hotReload = _hotReload;
+
+    for (auto &variant : variants)
+    {
+      hotReload->watch(*variant.second.shader, vertexPath, fragmentPath, variant.second.defines);
+    }
+  }
+
+  size_t count () const
+  {
+    return variants.size();
+  }
+
+  /**
+   * @brief Prints the number of variants and the build time of each one.
+   */
+  void report () const
+  {
+    double total = 0.0;
+
+    std::cout << "Shader variants of " << vertexPath << " + " << fragmentPath << ": " << variants.size() << std::endl;
+    for (const auto &variant : variants)
+    {
+      total += variant.second.buildSeconds;
+      std::cout << "  " << variant.second.description << ": "
+                << variant.second.buildSeconds * 1000.0 << " ms" << std::endl;
+    }
+    std::cout << "  total: " << total * 1000.0 << " ms" << std::endl;
+  }
+
+  /**
+   * @brief Deletes every variant built so far.
+   */
+  void clear ()
+  {
+    for (auto &variant : variants)
+    {
+      if (hotReload)
+      {
+        hotReload->unwatch(*variant.second.shader);
+      }
+      variant.second.shader->clear();
+    }
+    variants.clear();
+  }
+
+private:
+  struct Variant
+  {
+    std::unique_ptr<Shader> shader;
+    std::string description;
+    std::string defines;
+    double buildSeconds = 0.0;
+  };
+
+  std::string vertexPath;
+  std::string fragmentPath;
+  std::unordered_map<uint64_t, Variant> variants;
+  ShaderHotReload *hotReload = NULL;
+};
+
+#endif
@@ -0,0 +1,657 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SOFTWARE_RASTERIZER_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFTWARE_RASTERIZER_LANES 4
+#else
+#define SOFTWARE_RASTERIZER_LANES 1
+#endif
+
+#include "thread_pool.h"
+
+/**
+ * @brief Renders the lighting examples on the CPU, for machines without
+ * a GPU.
+ *
+ *   SoftwareRasterizer rasterizer(800, 600);
+ *   SoftwareRasterizer::Phong phong;
+ *   phong.model = model; phong.view = camera.GetViewMatrix(); ...
+ *
+ *   rasterizer.clear(glm::vec3(0.1f));
+ *   rasterizer.draw(vertices, 36, phong);
+ *   rasterizer.finish();
+ *   rasterizer.writePPM("frame.ppm");
+ *
+ * It takes the vertex arrays of 02b-basic-lighting (position and normal
+ * interleaved, drawn as GL_TRIANGLES) and reproduces textureless.vs.glsl
+ * plus the phong() of common/phong.glsl, with the rules of OpenGL:
+ * clipping against the near plane, depth test GL_LESS, pixel centers at
+ * half-integers, the top-left fill rule, perspective-correct
+ * interpolation and row 0 at the bottom.
+ *
+ * draw() only records the call. finish() renders everything in two
+ * parallel passes on a ThreadPool:
+ *
+ *   1. the triangles are split into chunks; each job transforms, clips
+ *      and sets up the triangles of a chunk and bins them into the TILE x
+ *      TILE pixel tiles their bounds touch, in lists of its own;
+ *   2. each job takes a tile, clears it and walks the bins of every
+ *      chunk in submission order, so tiles never share pixels and no
+ *      lock is needed.
+ *
+ * Edge functions are evaluated on a row of 8 pixels at once with AVX2 or
+ * 4 with SSE2. An edge shared by two triangles is always evaluated from
+ * the same endpoint, so both get exactly opposite values and no pixel is
+ * drawn twice or missed.
+ */
+class SoftwareRasterizer
+{
+public:
+  static const int TILE = 64;
+
+  // Uniforms of textureless.vs.glsl / textureless.fs.glsl
+  struct Phong
+  {
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::vec3 viewPos = glm::vec3(0.0f);
+    glm::vec3 lightPos = glm::vec3(1.2f, 1.0f, 2.0f);
+    glm::vec3 lightColor = glm::vec3(1.0f);
+    glm::vec3 objectColor = glm::vec3(1.0f, 0.5f, 0.31f);
+    float shininess = 128.0f;
+    bool specular = true;
+  };
+
+  struct Stats
+  {
+    size_t triangles = 0;   // Submitted
+    size_t rasterized = 0;  // Left after clipping and culling
+    size_t fragments = 0;   // Shaded (passed the depth test)
+  };
+
+  /**
+   * @param threads number of workers, one per hardware thread by default
+   */
+  SoftwareRasterizer (int _width, int _height, unsigned int threads = std::thread::hardware_concurrency()) :
+  width(_width),
+  height(_height),
+  columns((_width + TILE - 1) / TILE),
+  rows((_height + TILE - 1) / TILE),
+  color((size_t)_width * _height, 0),
+  depth((size_t)_width * _height, 1.0f),
+  pool(threads)
+  {
+  }
+
+  SoftwareRasterizer (const SoftwareRasterizer &) = delete;
+  SoftwareRasterizer &operator= (const SoftwareRasterizer &) = delete;
+
+  /**
+   * @brief Clears color and depth (to 1.0) at the start of the next
+   * finish().
+   */
+  void clear (const glm::vec3 &clearColor)
+  {
+    clearValue = pack(clearColor);
+    clearPending = true;
+  }
+
+  /**
+   * @brief Queues a glDrawArrays(GL_TRIANGLES, 0, count).
+   *
+   * @param vertices count vertices of 6 floats: position, normal; must
+   *   stay valid until finish()
+   */
+  void draw (const float *vertices, size_t count, const Phong &phong)
+  {
+    Draw call;
+
+    call.vertices = vertices;
+    call.triangles = count / 3;
+    call.phong = phong;
+    call.mvp = phong.projection * phong.view * phong.model;
+    draws.push_back(call);
+  }
+
+  /**
+   * @brief Renders every queued draw. Blocks until done.
+   */
+  void finish ()
+  {
+    size_t total = 0;
+
+    stats = Stats();
+    for (const Draw &call : draws)
+    {
+      total += call.triangles;
+    }
+    stats.triangles = total;
+
+    // Pass 1: a few chunks per worker, at least 64 triangles each
+    size_t count = pool.size() * 4, step;
+    count = total / 64 < count ? total / 64 : count;
+    count = count > 0 ? count : 1;
+    step = (total + count - 1) / count;
+
+    chunks.resize(count);
+    std::vector<std::future<void>> jobs;
+
+    for (size_t i = 0; i < count; i++)
+    {
+      Chunk &chunk = chunks[i];
+
+      chunk.first = i * step < total ? i * step : total;
+      chunk.last = chunk.first + step < total ? chunk.first + step : total;
+      jobs.push_back(pool.submit([this, &chunk] () { setup(chunk); }));
+    }
+    for (std::future<void> &job : jobs)
+    {
+      job.get();
+    }
+
+    // Pass 2: one job per tile
+    std::vector<size_t> fragments((size_t)columns * rows, 0);
+
+    jobs.clear();
+    for (int tile = 0; tile < columns * rows; tile++)
+    {
+      jobs.push_back(pool.submit([this, tile, &fragments] () { fragments[tile] = raster(tile); }));
+    }
+    for (std::future<void> &job : jobs)
+    {
+      job.get();
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+      stats.rasterized += chunks[i].triangles.size();
+    }
+    for (size_t tileFragments : fragments)
+    {
+      stats.fragments += tileFragments;
+    }
+
+    draws.clear();
+    clearPending = false;
+  }
+
+  int getWidth () const
+  {
+    return width;
+  }
+
+  int getHeight () const
+  {
+    return height;
+  }
+
+  unsigned int threads () const
+  {
+    return pool.size();
+  }
+
+  /**
+   * @brief RGBA8 pixels (R in the lowest byte), bottom row first like
+   * glReadPixels.
+   */
+  const uint32_t *pixels () const
+  {
+    return color.data();
+  }
+
+  const Stats &getStats () const
+  {
+    return stats;
+  }
+
+  /**
+   * @brief Writes the color buffer as a binary PPM, top row first.
+   */
+  bool writePPM (const std::string &path) const
+  {
+    FILE *file = fopen(path.c_str(), "wb");
+
+    if (!file)
+    {
+      std::cout << "ERROR::SOFTWARE_RASTERIZER::OUTPUT_NOT_WRITABLE " << path << std::endl;
+      return false;
+    }
+
+    std::vector<unsigned char> row((size_t)width * 3);
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    for (int y = height - 1; y >= 0; y--)
+    {
+      for (int x = 0; x < width; x++)
+      {
+        uint32_t pixel = color[(size_t)y * width + x];
+
+        row[x * 3 + 0] = (unsigned char)(pixel & 0xFF);
+        row[x * 3 + 1] = (unsigned char)((pixel >> 8) & 0xFF);
+        row[x * 3 + 2] = (unsigned char)((pixel >> 16) & 0xFF);
+      }
+      fwrite(row.data(), 1, row.size(), file);
+    }
+    fclose(file);
+
+    return true;
+  }
+
+private:
+  struct Draw
+  {
+    const float *vertices;
+    size_t triangles;
+    Phong phong;
+    glm::mat4 mvp;
+  };
+
+  // Output of the vertex shader
+  struct Vertex
+  {
+    glm::vec4 clip;
+    glm::vec3 world;
+    glm::vec3 normal;
+  };
+
+  // A triangle ready for the tiles, counter-clockwise on screen. Edge i is
+  // the one opposite vertex i.
+  struct Triangle
+  {
+    float invW[3];
+    float z[3];
+    glm::vec3 world[3];
+    glm::vec3 normal[3];
+    float originX[3], originY[3], deltaX[3], deltaY[3], sign[3];
+    bool topLeft[3];
+    int minX, minY, maxX, maxY;
+    unsigned int draw;
+  };
+
+  struct Chunk
+  {
+    size_t first = 0;
+    size_t last = 0;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<uint32_t>> bins;
+  };
+
+  static uint32_t pack (const glm::vec3 &value)
+  {
+    uint32_t result = 0xFF000000u;
+
+    for (int c = 0; c < 3; c++)
+    {
+      float channel = value[c] < 0.0f ? 0.0f : (value[c] > 1.0f ? 1.0f : value[c]);
+      result |= (uint32_t)(channel * 255.0f + 0.5f) << (c * 8);
+    }
+    return result;
+  }
+
+  // ---------------------------------------------------------------------
+  // Pass 1: vertex shader, clipping, setup and binning
+  // ---------------------------------------------------------------------
+
+  void setup (Chunk &chunk)
+  {
+    size_t index = 0;
+
+    chunk.triangles.clear();
+    chunk.bins.resize((size_t)columns * rows);
+    for (std::vector<uint32_t> &bin : chunk.bins)
+    {
+      bin.clear();
+    }
+
+    for (unsigned int d = 0; d < draws.size() && index < chunk.last; d++)
+    {
+      const Draw &call = draws[d];
+      size_t first = chunk.first > index ? chunk.first - index : 0;
+      size_t last = chunk.last - index < call.triangles ? chunk.last - index : call.triangles;
+
+      for (size_t t = first; t < last; t++)
+      {
+        Vertex triangle[3];
+
+        for (int v = 0; v < 3; v++)
+        {
+          const float *vertex = call.vertices + (t * 3 + v) * 6;
+          glm::vec4 position(vertex[0], vertex[1], vertex[2], 1.0f);
+
+          // textureless.vs.glsl: gl_Position, FragPos, Normal
+          triangle[v].clip = call.mvp * position;
+          triangle[v].world = glm::vec3(call.phong.model * position);
+          triangle[v].normal = glm::vec3(vertex[3], vertex[4], vertex[5]);
+        }
+
+        clip(chunk, triangle, d);
+      }
+
+      index += call.triangles;
+    }
+  }
+
+  static Vertex mix (const Vertex &a, const Vertex &b, float t)
+  {
+    Vertex result;
+
+    result.clip = a.clip + (b.clip - a.clip) * t;
+    result.world = a.world + (b.world - a.world) * t;
+    result.normal = a.normal + (b.normal - a.normal) * t;
+    return result;
+  }
+
+  void clip (Chunk &chunk, const Vertex triangle[3], unsigned int draw)
+  {
+    // Entirely outside one of the planes of the view volume
+    for (int axis = 0; axis < 3; axis++)
+    {
+      int below = 0, above = 0;
+
+      for (int v = 0; v < 3; v++)
+      {
+        below += triangle[v].clip[axis] < -triangle[v].clip.w;
+        above += triangle[v].clip[axis] > triangle[v].clip.w;
+      }
+      if (below == 3 || above == 3)
+      {
+        return;
+      }
+    }
+
+    // Against the near plane (z >= -w), which leaves w > 0 for the divide;
+    // the other planes are handled by the tile bounds and the depth test
+    Vertex polygon[4];
+    int count = 0;
+
+    for (int v = 0; v < 3; v++)
+    {
+      const Vertex &a = triangle[v], &b = triangle[(v + 1) % 3];
+      float da = a.clip.z + a.clip.w, db = b.clip.z + b.clip.w;
+
+      if (da >= 0.0f)
+      {
+        polygon[count++] = a;
+      }
+      if ((da >= 0.0f) != (db >= 0.0f))
+      {
+        polygon[count++] = mix(a, b, da / (da - db));
+      }
+    }
+
+    for (int v = 2; v < count; v++)
+    {
+      prepare(chunk, polygon[0], polygon[v - 1], polygon[v], draw);
+    }
+  }
+
+  void prepare (Chunk &chunk, const Vertex &a, const Vertex &b, const Vertex &c, unsigned int draw)
+  {
+    const Vertex *source[3] = {&a, &b, &c};
+    float x[3], y[3];
+    Triangle triangle;
+
+    for (int v = 0; v < 3; v++)
+    {
+      const glm::vec4 &clipped = source[v]->clip;
+
+      triangle.invW[v] = 1.0f / clipped.w;
+      x[v] = (clipped.x * triangle.invW[v] * 0.5f + 0.5f) * width;
+      y[v] = (clipped.y * triangle.invW[v] * 0.5f + 0.5f) * height;
+      triangle.z[v] = clipped.z * triangle.invW[v] * 0.5f + 0.5f;
+      triangle.world[v] = source[v]->world;
+      triangle.normal[v] = source[v]->normal;
+    }
+
+    // Both windings are drawn (GL_CULL_FACE is off), as counter-clockwise
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0.0f || std::isnan(area))
+    {
+      return;
+    }
+    if (area < 0.0f)
+    {
+      std::swap(x[1], x[2]);
+      std::swap(y[1], y[2]);
+      std::swap(triangle.invW[1], triangle.invW[2]);
+      std::swap(triangle.z[1], triangle.z[2]);
+      std::swap(triangle.world[1], triangle.world[2]);
+      std::swap(triangle.normal[1], triangle.normal[2]);
+    }
+
+    for (int e = 0; e < 3; e++)
+    {
+      int from = (e + 1) % 3, to = (e + 2) % 3;
+      float dx = x[to] - x[from], dy = y[to] - y[from];
+
+      // Always from the lower endpoint, so the neighbour sharing this edge
+      // computes the same products and gets exactly -w
+      bool forward = x[from] < x[to] || (x[from] == x[to] && y[from] < y[to]);
+      int origin = forward ? from : to;
+
+      triangle.originX[e] = x[origin];
+      triangle.originY[e] = y[origin];
+      triangle.deltaX[e] = forward ? dx : -dx;
+      triangle.deltaY[e] = forward ? dy : -dy;
+      triangle.sign[e] = forward ? 1.0f : -1.0f;
+
+      // With y up and counter-clockwise order, left edges go down and top
+      // edges go left
+      triangle.topLeft[e] = dy < 0.0f || (dy == 0.0f && dx < 0.0f);
+    }
+
+    // Pixels whose centers (i + 0.5) fall inside the bounds
+    float minX = std::fmin(x[0], std::fmin(x[1], x[2])), maxX = std::fmax(x[0], std::fmax(x[1], x[2]));
+    float minY = std::fmin(y[0], std::fmin(y[1], y[2])), maxY = std::fmax(y[0], std::fmax(y[1], y[2]));
+
+    triangle.minX = minX - 0.5f < 0.0f ? 0 : (int)std::ceil(minX - 0.5f);
+    triangle.minY = minY - 0.5f < 0.0f ? 0 : (int)std::ceil(minY - 0.5f);
+    triangle.maxX = maxX - 0.5f > width - 1 ? width - 1 : (int)std::floor(maxX - 0.5f);
+    triangle.maxY = maxY - 0.5f > height - 1 ? height - 1 : (int)std::floor(maxY - 0.5f);
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+    {
+      return;
+    }
+    triangle.draw = draw;
+
+    uint32_t index = (uint32_t)chunk.triangles.size();
+    chunk.triangles.push_back(triangle);
+
+    for (int ty = triangle.minY / TILE; ty <= triangle.maxY / TILE; ty++)
+    {
+      for (int tx = triangle.minX / TILE; tx <= triangle.maxX / TILE; tx++)
+      {
+        chunk.bins[(size_t)ty * columns + tx].push_back(index);
+      }
+    }
+  }
+
+  // ---------------------------------------------------------------------
+  // Pass 2: coverage, depth test and shading, tile by tile
+  // ---------------------------------------------------------------------
+
+  /**
+   * Edge functions of count pixels of a row starting at centerX.
+   *
+   * @return a bit per covered pixel; the values of the edge functions of
+   *   every lane are left in w
+   */
+  static unsigned int coverage (const Triangle &triangle, float centerX, float centerY, int count,
+                                float w[3][SOFTWARE_RASTERIZER_LANES])
+  {
+#if SOFTWARE_RASTERIZER_LANES == 8
+    __m256 px = _mm256_add_ps(_mm256_set1_ps(centerX), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1)), zero = _mm256_setzero_ps();
+
+    for (int e = 0; e < 3; e++)
+    {
+      __m256 dy = _mm256_set1_ps(centerY - triangle.originY[e]);
+      __m256 dx = _mm256_sub_ps(px, _mm256_set1_ps(triangle.originX[e]));
+      __m256 value = _mm256_mul_ps(_mm256_set1_ps(triangle.sign[e]),
+                                   _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(triangle.deltaX[e]), dy),
+                                                 _mm256_mul_ps(_mm256_set1_ps(triangle.deltaY[e]), dx)));
+      __m256 edge = triangle.topLeft[e] ? _mm256_cmp_ps(value, zero, _CMP_GE_OQ) : _mm256_cmp_ps(value, zero, _CMP_GT_OQ);
+
+      inside = _mm256_and_ps(inside, edge);
+      _mm256_storeu_ps(w[e], value);
+    }
+
+    return (unsigned int)_mm256_movemask_ps(inside) & ((1u << count) - 1);
+#elif SOFTWARE_RASTERIZER_LANES == 4
+    __m128 px = _mm_add_ps(_mm_set1_ps(centerX), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1)), zero = _mm_setzero_ps();
+
+    for (int e = 0; e < 3; e++)
+    {
+      __m128 dy = _mm_set1_ps(centerY - triangle.originY[e]);
+      __m128 dx = _mm_sub_ps(px, _mm_set1_ps(triangle.originX[e]));
+      __m128 value = _mm_mul_ps(_mm_set1_ps(triangle.sign[e]),
+                                _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(triangle.deltaX[e]), dy),
+                                           _mm_mul_ps(_mm_set1_ps(triangle.deltaY[e]), dx)));
+      __m128 edge = triangle.topLeft[e] ? _mm_cmpge_ps(value, zero) : _mm_cmpgt_ps(value, zero);
+
+      inside = _mm_and_ps(inside, edge);
+      _mm_storeu_ps(w[e], value);
+    }
+
+    return (unsigned int)_mm_movemask_ps(inside) & ((1u << count) - 1);
+#else
+    bool inside = count > 0;
+
+    for (int e = 0; e < 3; e++)
+    {
+      float value = triangle.sign[e] * (triangle.deltaX[e] * (centerY - triangle.originY[e]) -
+                                        triangle.deltaY[e] * (centerX - triangle.originX[e]));
+
+      inside = inside && (triangle.topLeft[e] ? value >= 0.0f : value > 0.0f);
+      w[e][0] = value;
+    }
+
+    return inside ? 1u : 0u;
+#endif
+  }
+
+  // phong() of common/phong.glsl, times objectColor
+  static uint32_t shade (const Phong &phong, const glm::vec3 &normal, const glm::vec3 &fragPos)
+  {
+    glm::vec3 ambientLight = 0.1f * phong.lightColor;
+
+    glm::vec3 norm = glm::normalize(normal);
+    glm::vec3 lightDir = glm::normalize(phong.lightPos - fragPos);
+    float diff = std::fmax(glm::dot(norm, lightDir), 0.0f);
+    glm::vec3 result = ambientLight + diff * phong.lightColor;
+
+    if (phong.specular)
+    {
+      glm::vec3 viewDir = glm::normalize(phong.viewPos - fragPos);
+      glm::vec3 reflectDir = glm::reflect(-lightDir, norm);
+      float spec = std::pow(std::fmax(glm::dot(viewDir, reflectDir), 0.0f), phong.shininess);
+
+      result = result + 0.5f * spec * phong.lightColor;
+    }
+
+    return pack(result * phong.objectColor);
+  }
+
+  // Renders one tile. Returns the number of fragments shaded.
+  size_t raster (int tile)
+  {
+    int tileX = (tile % columns) * TILE, tileY = (tile / columns) * TILE;
+    int lastX = tileX + TILE - 1 < width - 1 ? tileX + TILE - 1 : width - 1;
+    int lastY = tileY + TILE - 1 < height - 1 ? tileY + TILE - 1 : height - 1;
+    size_t fragments = 0;
+
+    if (clearPending)
+    {
+      for (int y = tileY; y <= lastY; y++)
+      {
+        std::fill(&color[(size_t)y * width + tileX], &color[(size_t)y * width + lastX] + 1, clearValue);
+        std::fill(&depth[(size_t)y * width + tileX], &depth[(size_t)y * width + lastX] + 1, 1.0f);
+      }
+    }
+
+    for (const Chunk &chunk : chunks)
+    {
+      for (uint32_t index : chunk.bins[tile])
+      {
+        const Triangle &triangle = chunk.triangles[index];
+        const Phong &phong = draws[triangle.draw].phong;
+        int x0 = triangle.minX > tileX ? triangle.minX : tileX, x1 = triangle.maxX < lastX ? triangle.maxX : lastX;
+        int y0 = triangle.minY > tileY ? triangle.minY : tileY, y1 = triangle.maxY < lastY ? triangle.maxY : lastY;
+
+        for (int y = y0; y <= y1; y++)
+        {
+          for (int x = x0; x <= x1; x += SOFTWARE_RASTERIZER_LANES)
+          {
+            int count = x1 - x + 1 < SOFTWARE_RASTERIZER_LANES ? x1 - x + 1 : SOFTWARE_RASTERIZER_LANES;
+            float w[3][SOFTWARE_RASTERIZER_LANES];
+            unsigned int mask = coverage(triangle, x + 0.5f, y + 0.5f, count, w);
+
+            for (int lane = 0; mask; lane++, mask >>= 1)
+            {
+              if (!(mask & 1))
+              {
+                continue;
+              }
+
+              size_t pixel = (size_t)y * width + x + lane;
+              float sum = w[0][lane] + w[1][lane] + w[2][lane];
+              float l[3] = {w[0][lane] / sum, w[1][lane] / sum, w[2][lane] / sum};
+              float z = l[0] * triangle.z[0] + l[1] * triangle.z[1] + l[2] * triangle.z[2];
+
+              if (!(z < depth[pixel]) || z < 0.0f)
+              {
+                continue;
+              }
+
+              // Perspective-correct FragPos and Normal
+              float q[3] = {l[0] * triangle.invW[0], l[1] * triangle.invW[1], l[2] * triangle.invW[2]};
+              float invQ = 1.0f / (q[0] + q[1] + q[2]);
+              glm::vec3 fragPos = (triangle.world[0] * q[0] + triangle.world[1] * q[1] + triangle.world[2] * q[2]) * invQ;
+              glm::vec3 normal = (triangle.normal[0] * q[0] + triangle.normal[1] * q[1] + triangle.normal[2] * q[2]) * invQ;
+
+              depth[pixel] = z;
+              color[pixel] = shade(phong, normal, fragPos);
+              fragments++;
+            }
+          }
+        }
+      }
+    }
+
+    return fragments;
+  }
+
+  int width;
+  int height;
+  int columns;
+  int rows;
+  std::vector<uint32_t> color;
+  std::vector<float> depth;
+  uint32_t clearValue = 0xFF000000u;
+  bool clearPending = false;
+  std::vector<Draw> draws;
+  std::vector<Chunk> chunks;
+  Stats stats;
+  ThreadPool pool;
+};
+
+#endif
@@ -0,0 +1,488 @@
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TEXTURE_FILE_MMAP 1
+#endif
+
+#include "block_compression.h"
+#include "gl_ext.h"
+#include "gl_state.h"
+#include "stb_image.h"
+
+/**
+ * @brief A cooked texture: the pixels of every mip level, already in the
+ * format glTexImage2D takes, in one file that is mapped and uploaded as
+ * is.
+ *
+ *   TextureFile::cook("container.jpg", "container.lgtx", true);
+ *   ...
+ *   TextureFile file("container.lgtx");
+ *   file.upload(texture);
+ *
+ * cook() does offline what every run of the examples used to do at
+ * startup: decode the image with stb_image (flipped or not, as with
+ * stbi_set_flip_vertically_on_load) and build the mip chain, with the
+ * same 2x2 box filter as glGenerateMipmap. At runtime there is nothing
+ * left but mapping the file and handing each level to glTexImage2D.
+ *
+ * Levels can also be block compressed (BC1, BC3 or BC7, see
+ * BlockCompression) and then go to glCompressedTexImage2D as they are.
+ * Without the S3TC or BPTC extension they are decompressed on the CPU
+ * and uploaded uncompressed instead.
+ *
+ * Layout, little-endian:
+ *
+ *   Header                    "LGTX", version, size, GL formats, levels
+ *   Level[levels]             offset and size of each level in the file
+ *   pixels                    each level 64-byte aligned, rows tightly
+ *                             packed, bottom row first when flipped
+ *
+ * A compressed file has type 0, its compressed GL format as the internal
+ * format and GL_RGB or GL_RGBA as the format, which is what its pixels
+ * are decompressed to when needed.
+ */
+class TextureFile
+{
+public:
+  static const uint32_t VERSION = 1;
+  static const uint32_t FLIPPED = 1;
+
+  struct Header
+  {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t internalFormat;
+    uint32_t format;
+    uint32_t type;
+    uint32_t levels;
+    uint32_t flags;
+    uint32_t reserved;
+  };
+
+  struct Level
+  {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+  };
+
+  TextureFile () {}
+
+  explicit TextureFile (const std::string &path)
+  {
+    open(path);
+  }
+
+  ~TextureFile ()
+  {
+    close();
+  }
+
+  TextureFile (const TextureFile &) = delete;
+  TextureFile &operator= (const TextureFile &) = delete;
+
+  /**
+   * @brief Decodes an image and writes it cooked.
+   *
+   * @param flip whether to flip it vertically, as the examples do with
+   *   stbi_set_flip_vertically_on_load(true)
+   *
+   * @param mipmaps whether to store the whole mip chain or only level 0
+   *
+   * @param compression block compression of every level, NONE to store
+   *   them as GL_R8 to GL_RGBA8; BC1 drops the alpha channel
+   *
+   * @param pool workers for the compression, NULL to compress on the
+   *   calling thread
+   *
+   * @return false (and prints an error) if the image cannot be read or
+   *   the file cannot be written
+   */
+  static bool cook (const std::string &source, const std::string &destination, bool flip = false, bool mipmaps = true,
+                    BlockCompression::Format compression = BlockCompression::NONE, ThreadPool *pool = NULL)
+  {
+    static const GLenum FORMATS[] = {GL_RED, GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    static const GLenum INTERNAL_FORMATS[] = {GL_R8, GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+    int width, height, channels;
+
+    stbi_set_flip_vertically_on_load_thread(flip);
+    unsigned char *pixels = stbi_load(source.c_str(), &width, &height, &channels, 0);
+    if (!pixels)
+    {
+      const char *reason = stbi_failure_reason();
+      std::cout << "ERROR::TEXTURE_FILE::LOAD_FAILED " << source << ": " << (reason ? reason : "unknown error") << std::endl;
+      return false;
+    }
+
+    // Level 0, then each level from the previous one
+    std::vector<std::vector<unsigned char>> chain(1);
+    std::vector<Level> levels(1);
+
+    chain[0].assign(pixels, pixels + (size_t)width * height * channels);
+    levels[0].width = (uint32_t)width;
+    levels[0].height = (uint32_t)height;
+    stbi_image_free(pixels);
+
+    while (mipmaps && (levels.back().width > 1 || levels.back().height > 1))
+    {
+      const Level &last = levels.back();
+      Level level;
+
+      level.width = last.width > 1 ? last.width / 2 : 1;
+      level.height = last.height > 1 ? last.height / 2 : 1;
+      chain.push_back(downsample(chain.back(), last.width, last.height, level.width, level.height, channels));
+      levels.push_back(level);
+    }
+
+    Header header = {{'L', 'G', 'T', 'X'}, VERSION, (uint32_t)width, (uint32_t)height,
+                     INTERNAL_FORMATS[channels], FORMATS[channels], GL_UNSIGNED_BYTE,
+                     (uint32_t)levels.size(), flip ? FLIPPED : 0, 0};
+
+    if (compression != BlockCompression::NONE)
+    {
+      for (size_t i = 0; i < levels.size(); i++)
+      {
+        chain[i] = BlockCompression::compress(chain[i].data(), (int)levels[i].width, (int)levels[i].height,
+                                              channels, compression, pool);
+      }
+
+      header.internalFormat = compressedFormat(compression);
+      header.format = compression == BlockCompression::BC1 ? GL_RGB : GL_RGBA;
+      header.type = 0;
+    }
+    uint64_t offset = sizeof(Header) + sizeof(Level) * levels.size();
+
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+      offset = align(offset);
+      levels[i].offset = offset;
+      levels[i].size = chain[i].size();
+      offset += chain[i].size();
+    }
+
+    FILE *file = fopen(destination.c_str(), "wb");
+    if (!file)
+    {
+      std::cout << "ERROR::TEXTURE_FILE::WRITE_FAILED " << destination << std::endl;
+      return false;
+    }
+
+    static const unsigned char PADDING[64] = {0};
+    bool written = fwrite(&header, sizeof(Header), 1, file) == 1 &&
+                   fwrite(levels.data(), sizeof(Level), levels.size(), file) == levels.size();
+    uint64_t position = sizeof(Header) + sizeof(Level) * levels.size();
+
+    for (size_t i = 0; written && i < levels.size(); i++)
+    {
+      written = fwrite(PADDING, 1, (size_t)(levels[i].offset - position), file) == levels[i].offset - position &&
+                fwrite(chain[i].data(), 1, chain[i].size(), file) == chain[i].size();
+      position = levels[i].offset + levels[i].size;
+    }
+
+    if (fclose(file) != 0 || !written)
+    {
+      std::cout << "ERROR::TEXTURE_FILE::WRITE_FAILED " << destination << std::endl;
+      remove(destination.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Maps a cooked file, releasing the previous one.
+   *
+   * @return false (and prints an error) if the file cannot be read or is
+   *   not a valid cooked texture
+   */
+  bool open (const std::string &path)
+  {
+    close();
+
+#ifdef TEXTURE_FILE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info;
+
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+      }
+      return fail(path, "READ_FAILED");
+    }
+
+    void *address = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+    {
+      return fail(path, "READ_FAILED");
+    }
+
+    // Start reading the whole file ahead instead of faulting it in page
+    // by page during the upload
+    madvise(address, (size_t)info.st_size, MADV_WILLNEED);
+
+    bytes = (const unsigned char *)address;
+    length = (size_t)info.st_size;
+    mapped = true;
+#else
+    FILE *file = fopen(path.c_str(), "rb");
+
+    if (!file)
+    {
+      return fail(path, "READ_FAILED");
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    buffer.resize(size > 0 ? (size_t)size : 0);
+    if (size <= 0 || fread(buffer.data(), 1, buffer.size(), file) != buffer.size())
+    {
+      fclose(file);
+      return fail(path, "READ_FAILED");
+    }
+    fclose(file);
+
+    bytes = buffer.data();
+    length = buffer.size();
+#endif
+
+    if (!validate())
+    {
+      close();
+      return fail(path, "INVALID");
+    }
+
+    return true;
+  }
+
+  void close ()
+  {
+#ifdef TEXTURE_FILE_MMAP
+    if (mapped)
+    {
+      munmap((void *)bytes, length);
+    }
+#endif
+    bytes = NULL;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+  }
+
+  bool isOpen () const
+  {
+    return bytes != NULL;
+  }
+
+  const Header &header () const
+  {
+    return *(const Header *)bytes;
+  }
+
+  const Level &level (unsigned int i) const
+  {
+    return ((const Level *)(bytes + sizeof(Header)))[i];
+  }
+
+  const unsigned char *pixels (unsigned int i) const
+  {
+    return bytes + level(i).offset;
+  }
+
+  /**
+   * @brief Reads one byte of every page, so the file is faulted in by the
+   * calling thread (e.g. a loader worker) instead of inside glTexImage2D.
+   */
+  void touch () const
+  {
+    volatile unsigned char sink = 0;
+
+    for (size_t i = 0; i < length; i += 4096)
+    {
+      sink += bytes[i];
+    }
+    (void)sink;
+  }
+
+  bool isCompressed () const
+  {
+    return header().type == 0;
+  }
+
+  /**
+   * @brief Uploads every level of the file to a 2D texture, bound through
+   * GLState on texture unit 0.
+   *
+   * GL_TEXTURE_MAX_LEVEL is set to the last level in the file, so a file
+   * cooked without mipmaps is still complete with a mipmap filter.
+   */
+  void upload (unsigned int texture) const
+  {
+    const Header &info = header();
+    BlockCompression::Format compression = blockFormat(info.internalFormat);
+    bool decompress = isCompressed() && !gl_supports_compressed_format(info.internalFormat);
+
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)info.levels - 1);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned int i = 0; i < info.levels; i++)
+    {
+      GLsizei width = level(i).width, height = level(i).height;
+
+      if (decompress)
+      {
+        std::vector<unsigned char> rgba = BlockCompression::decompress(pixels(i), width, height, compression);
+        GLenum internalFormat = info.format == GL_RGB ? GL_RGB8 : GL_RGBA8;
+
+        glTexImage2D(GL_TEXTURE_2D, i, internalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+      }
+      else if (isCompressed())
+      {
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, info.internalFormat, width, height, 0, (GLsizei)level(i).size, pixels(i));
+      }
+      else
+      {
+        glTexImage2D(GL_TEXTURE_2D, i, info.internalFormat, width, height, 0, info.format, info.type, pixels(i));
+      }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  }
+
+private:
+  static GLenum compressedFormat (BlockCompression::Format compression)
+  {
+    switch (compression)
+    {
+      case BlockCompression::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      case BlockCompression::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      default: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+  }
+
+  static BlockCompression::Format blockFormat (GLenum internalFormat)
+  {
+    switch (internalFormat)
+    {
+      case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: return BlockCompression::BC1;
+      case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return BlockCompression::BC3;
+      case GL_COMPRESSED_RGBA_BPTC_UNORM: return BlockCompression::BC7;
+      default: return BlockCompression::NONE;
+    }
+  }
+
+  static uint64_t align (uint64_t offset)
+  {
+    return (offset + 63) & ~(uint64_t)63;
+  }
+
+  static int channels (GLenum format)
+  {
+    switch (format)
+    {
+      case GL_RED: return 1;
+      case GL_RG: return 2;
+      case GL_RGB: return 3;
+      case GL_RGBA: return 4;
+      default: return 0;
+    }
+  }
+
+  // Averages 2x2 blocks; on odd sizes the last column/row is clamped
+  static std::vector<unsigned char> downsample (const std::vector<unsigned char> &source, uint32_t width, uint32_t height,
+                                                uint32_t newWidth, uint32_t newHeight, int channels)
+  {
+    std::vector<unsigned char> result((size_t)newWidth * newHeight * channels);
+
+    for (uint32_t y = 0; y < newHeight; y++)
+    {
+      uint32_t y0 = y * 2 < height ? y * 2 : height - 1;
+      uint32_t y1 = y * 2 + 1 < height ? y * 2 + 1 : height - 1;
+
+      for (uint32_t x = 0; x < newWidth; x++)
+      {
+        uint32_t x0 = x * 2 < width ? x * 2 : width - 1;
+        uint32_t x1 = x * 2 + 1 < width ? x * 2 + 1 : width - 1;
+
+        for (int c = 0; c < channels; c++)
+        {
+          unsigned int sum = source[((size_t)y0 * width + x0) * channels + c] +
+                             source[((size_t)y0 * width + x1) * channels + c] +
+                             source[((size_t)y1 * width + x0) * channels + c] +
+                             source[((size_t)y1 * width + x1) * channels + c];
+
+          result[((size_t)y * newWidth + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+        }
+      }
+    }
+
+    return result;
+  }
+
+  // Everything upload() will read must be inside the file
+  bool validate () const
+  {
+    if (length < sizeof(Header) || memcmp(bytes, "LGTX", 4) != 0)
+    {
+      return false;
+    }
+
+    const Header &info = header();
+    BlockCompression::Format compression = blockFormat(info.internalFormat);
+
+    if (info.version != VERSION || info.levels == 0 || info.levels > 32 ||
+        length < sizeof(Header) + sizeof(Level) * info.levels || channels(info.format) == 0 ||
+        (info.type != GL_UNSIGNED_BYTE && (info.type != 0 || compression == BlockCompression::NONE)))
+    {
+      return false;
+    }
+
+    for (unsigned int i = 0; i < info.levels; i++)
+    {
+      const Level &entry = level(i);
+      uint64_t expected = info.type == 0 ? BlockCompression::compressedSize((int)entry.width, (int)entry.height, compression)
+                                         : (uint64_t)entry.width * entry.height * channels(info.format);
+
+      if (entry.size != expected || entry.offset > length || entry.size > length - entry.offset)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool fail (const std::string &path, const char *reason)
+  {
+    std::cout << "ERROR::TEXTURE_FILE::" << reason << " " << path << std::endl;
+    return false;
+  }
+
+  const unsigned char *bytes = NULL;
+  size_t length = 0;
+  bool mapped = false;
+  std::vector<unsigned char> buffer;
+};
+
+#endif
@@ -0,0 +1,307 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gl_state.h"
+#include "mpsc_queue.h"
+#include "stb_image.h"
+#include "texture_file.h"
+#include "texture_streamer.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Decodes image files on worker threads and uploads them as 2D
+ * textures on the GL thread.
+ *
+ *   TextureLoader loader;
+ *   unsigned int container = loader.load("../../textures/container.jpg");
+ *   unsigned int face = loader.load("../../textures/awesomeface.png", true);
+ *   loader.finish();
+ *
+ * load() creates the texture name right away and queues the decode on a
+ * ThreadPool, so every file is decoded at the same time and loading N
+ * images takes about as long as the slowest one instead of the sum of
+ * all of them. Workers hand the pixels back through an MpscQueue, with
+ * no lock; update() (once per frame) or finish() (once, at startup)
+ * uploads them with glTexImage2D and builds the mipmaps.
+ *
+ * With setStreamer() the pixels go through a TextureStreamer instead,
+ * spread over frames within its budget, and the textures are complete
+ * once TextureStreamer::update() has copied their last rows.
+ *
+ * Files cooked by TextureFile::cook() (.lgtx) are mapped instead of
+ * decoded and come with their mip chain; their flip was decided when
+ * cooking. They are always uploaded directly, without the streamer.
+ *
+ * A texture that is not uploaded yet samples as black. Uploads bind
+ * through GLState on texture unit 0.
+ */
+class TextureLoader
+{
+public:
+  struct Options
+  {
+    bool flip = false;
+    bool mipmaps = true;
+    GLint wrap = GL_REPEAT;
+    GLint minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLint magFilter = GL_LINEAR;
+  };
+
+  struct Stats
+  {
+    unsigned int loaded = 0;
+    unsigned int failed = 0;
+    double decodeMs = 0.0;     // Sum over every image, on the workers
+    double maxDecodeMs = 0.0;  // Slowest image
+    double uploadMs = 0.0;     // On the GL thread
+  };
+
+  /**
+   * @param threads number of decoding workers, one per hardware thread
+   *   by default
+   */
+  explicit TextureLoader (unsigned int threads = std::thread::hardware_concurrency()) :
+  pool(new ThreadPool(threads))
+  {
+  }
+
+  ~TextureLoader ()
+  {
+    // Let the workers finish before freeing what they queued
+    pool.reset();
+
+    std::vector<Image> images;
+    decoded.popAll(images);
+    for (Image &image : images)
+    {
+      stbi_image_free(image.pixels);
+    }
+  }
+
+  TextureLoader (const TextureLoader &) = delete;
+  TextureLoader &operator= (const TextureLoader &) = delete;
+
+  /**
+   * @brief Starts loading an image. Returns immediately.
+   *
+   * Call from the thread that owns the GL context.
+   *
+   * @return the texture name, usable before the pixels arrive
+   */
+  unsigned int load (const std::string &path, const Options &options)
+  {
+    unsigned int texture;
+
+    glGenTextures(1, &texture);
+    pending++;
+
+    pool->submit([this, path, options, texture] () {
+      auto start = std::chrono::steady_clock::now();
+      Image image;
+
+      if (cooked(path))
+      {
+        image.file.reset(new TextureFile());
+        if (image.file->open(path))
+        {
+          image.file->touch();
+        }
+        else
+        {
+          image.file.reset();
+          image.error = "not a valid cooked texture";
+        }
+      }
+      else
+      {
+        // The flag of stbi_set_flip_vertically_on_load is global; this one
+        // only affects the calling thread
+        stbi_set_flip_vertically_on_load_thread(options.flip);
+        image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+        if (!image.pixels)
+        {
+          const char *reason = stbi_failure_reason();
+          image.error = reason ? reason : "unknown error";
+        }
+      }
+      image.path = path;
+      image.options = options;
+      image.texture = texture;
+
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      image.decodeMs = elapsed.count();
+
+      decoded.push(std::move(image));
+    });
+
+    return texture;
+  }
+
+  unsigned int load (const std::string &path, bool flip = false)
+  {
+    Options options;
+    options.flip = flip;
+
+    return load(path, options);
+  }
+
+  /**
+   * @brief Uploads the images decoded so far. Never waits.
+   *
+   * @return the number of images still being decoded
+   */
+  unsigned int update ()
+  {
+    std::vector<Image> images;
+
+    if (decoded.popAll(images) == 0)
+    {
+      return pending;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (Image &image : images)
+    {
+      upload(image);
+      pending--;
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    stats.uploadMs += elapsed.count();
+
+    return pending;
+  }
+
+  /**
+   * @brief Uploads every requested image, waiting for the decodes.
+   */
+  void finish ()
+  {
+    while (update() > 0)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Routes the uploads through a streamer; NULL goes back to
+   * glTexImage2D.
+   */
+  void setStreamer (TextureStreamer *_streamer)
+  {
+    streamer = _streamer;
+  }
+
+  unsigned int pendingCount () const
+  {
+    return pending;
+  }
+
+  const Stats &getStats () const
+  {
+    return stats;
+  }
+
+private:
+  struct Image
+  {
+    std::string path;
+    std::string error;
+    Options options;
+    std::unique_ptr<TextureFile> file;
+    unsigned int texture = 0;
+    unsigned char *pixels = NULL;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    double decodeMs = 0.0;
+  };
+
+  static bool cooked (const std::string &path)
+  {
+    return path.size() > 5 && path.compare(path.size() - 5, 5, ".lgtx") == 0;
+  }
+
+  void upload (Image &image)
+  {
+    static const GLenum FORMATS[] = {GL_RED, GL_RED, GL_RG, GL_RGB, GL_RGBA};
+
+    stats.decodeMs += image.decodeMs;
+    stats.maxDecodeMs = image.decodeMs > stats.maxDecodeMs ? image.decodeMs : stats.maxDecodeMs;
+
+    if (!image.pixels && !image.file)
+    {
+      std::cout << "ERROR::TEXTURE_LOADER::LOAD_FAILED " << image.path << ": " << image.error << std::endl;
+      stats.failed++;
+      return;
+    }
+
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D, image.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, image.options.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, image.options.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, image.options.minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, image.options.magFilter);
+
+    if (image.file)
+    {
+      image.file->upload(image.texture);
+
+      // Only when the file was cooked without its mip chain, and not for
+      // block-compressed levels, which glGenerateMipmap cannot build from:
+      // those keep the GL_TEXTURE_MAX_LEVEL of 0 upload() set
+      if (image.options.mipmaps && image.file->header().levels == 1 && !image.file->isCompressed())
+      {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+        glGenerateMipmap(GL_TEXTURE_2D);
+      }
+
+      image.file.reset();
+      stats.loaded++;
+      return;
+    }
+
+    GLenum format = FORMATS[image.channels];
+
+    if (streamer)
+    {
+      unsigned char *pixels = image.pixels;
+
+      streamer->upload(image.texture, image.width, image.height, format, pixels,
+                       [pixels] () { stbi_image_free(pixels); }, image.options.mipmaps);
+      image.pixels = NULL;
+      stats.loaded++;
+      return;
+    }
+
+    // Rows of RGB images are not always a multiple of 4 bytes long
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (image.options.mipmaps)
+    {
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    stbi_image_free(image.pixels);
+    image.pixels = NULL;
+    stats.loaded++;
+  }
+
+  MpscQueue<Image> decoded;
+  std::unique_ptr<ThreadPool> pool;
+  TextureStreamer *streamer = NULL;
+  unsigned int pending = 0;
+  Stats stats;
+};
+
+#endif
@@ -0,0 +1,424 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "gl_ext.h"
+#include "gl_state.h"
+
+/**
+ * @brief Streams texture pixels to the GPU through pixel buffer objects,
+ * a few rows at a time, without ever waiting for the driver.
+ *
+ * Pixels are copied into a ring of SEGMENTS pixel unpack buffers, one
+ * segment per frame, and glTexSubImage2D reads them from there. The copy
+ * from the buffer into the texture is done by the GPU, after the call
+ * returns. Each segment is fenced (glFenceSync) once its frame's copies
+ * are issued; it is written again only when glClientWaitSync, with a
+ * zero timeout, says that fence has passed. A segment that is still in
+ * use skips the frame instead of stalling it.
+ *
+ * With ARB_buffer_storage (GL 4.4) the segments are mapped once,
+ * persistently and coherently. Otherwise each segment is mapped with
+ * GL_MAP_UNSYNCHRONIZED_BIT, safe since the fence already passed, and
+ * unmapped before the copies are issued.
+ *
+ * The budget caps the bytes copied per update(). Textures are split into
+ * bands of whole rows, so one large texture is spread over several
+ * frames instead of causing a hitch. Their storage is allocated up front
+ * by upload(); the texture samples as black until its last band lands.
+ *
+ * Use from the thread that owns the GL context.
+ */
+class TextureStreamer
+{
+public:
+  static const unsigned int SEGMENTS = 3;
+
+  struct Stats
+  {
+    size_t bytes = 0;            // Copied into the ring since creation
+    size_t maxFrameBytes = 0;    // Largest update()
+    unsigned int textures = 0;   // Fully uploaded
+    unsigned int fenceSkips = 0; // Frames the next segment was still busy
+  };
+
+  /**
+   * @brief Creates the ring. Must be called with the GL context current.
+   *
+   * @param load the loader given to gladLoadGLLoader, used to look for
+   *   ARB_buffer_storage
+   *
+   * @param _segmentBytes size of each of the SEGMENTS buffers; no more
+   *   than this is copied per frame
+   *
+   * @param _budget bytes copied per update(), at most _segmentBytes
+   */
+  TextureStreamer (GLADloadproc load, size_t _segmentBytes = 16 << 20, size_t _budget = 4 << 20) :
+  segmentBytes(_segmentBytes)
+  {
+    gl_ext_load(load);
+    persistent = gl_ext().ARB_buffer_storage;
+
+    glGenBuffers(SEGMENTS, buffers);
+    for (unsigned int i = 0; i < SEGMENTS; i++)
+    {
+      GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[i]);
+
+      if (persistent)
+      {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        gl_ext().BufferStorage(GL_PIXEL_UNPACK_BUFFER, segmentBytes, NULL, flags);
+        mapped[i] = (unsigned char *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, segmentBytes, flags);
+      }
+      else
+      {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, segmentBytes, NULL, GL_STREAM_DRAW);
+        mapped[i] = NULL;
+      }
+      fences[i] = 0;
+    }
+    GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    setBudget(_budget);
+  }
+
+  ~TextureStreamer ()
+  {
+    clear();
+  }
+
+  TextureStreamer (const TextureStreamer &) = delete;
+  TextureStreamer &operator= (const TextureStreamer &) = delete;
+
+  void setBudget (size_t bytesPerFrame)
+  {
+    budget = bytesPerFrame < segmentBytes ? bytesPerFrame : segmentBytes;
+  }
+
+  size_t getBudget () const
+  {
+    return budget;
+  }
+
+  bool isPersistent () const
+  {
+    return persistent;
+  }
+
+  /**
+   * @brief Allocates the texture's storage and queues its pixels.
+   *
+   * @param texture a texture name, made a 2D texture here
+   *
+   * @param format GL_RED, GL_RG, GL_RGB or GL_RGBA, 8 bits per channel;
+   *   also used as the internal format
+   *
+   * @param pixels rows bottom to top, tightly packed; must stay valid
+   *   until release is called
+   *
+   * @param release called once the last row has been copied into the
+   *   ring, e.g. to free pixels
+   *
+   * @param mipmaps whether to build the mipmaps after the last band
+   */
+  void upload (unsigned int texture, int width, int height, GLenum format, const unsigned char *pixels,
+               std::function<void()> release = std::function<void()>(), bool mipmaps = true)
+  {
+    Pending upload;
+
+    upload.texture = texture;
+    upload.width = width;
+    upload.height = height;
+    upload.format = format;
+    upload.rowBytes = (size_t)width * channels(format);
+    upload.pixels = pixels;
+    upload.release = release;
+    upload.mipmaps = mipmaps;
+
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D, texture);
+
+    // A single row that does not fit in a segment can only go directly
+    if (upload.rowBytes > segmentBytes)
+    {
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      finish(upload);
+      return;
+    }
+
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, NULL);
+    queue.push_back(upload);
+  }
+
+  /**
+   * @brief Copies up to the budget into the next segment and issues the
+   * texture copies from it. Call once per frame. Never waits.
+   *
+   * @return the number of textures not fully uploaded yet
+   */
+  unsigned int update ()
+  {
+    if (queue.empty())
+    {
+      return 0;
+    }
+
+    if (!acquire(current, 0))
+    {
+      stats.fenceSkips++;
+      return (unsigned int)queue.size();
+    }
+
+    stream(budget);
+    return (unsigned int)queue.size();
+  }
+
+  /**
+   * @brief Uploads everything queued, ignoring the budget and waiting for
+   * the segments as needed. Meant for loading screens.
+   *
+   * If waiting on a segment fails (GL_WAIT_FAILED), the GPU may still be
+   * reading it: the flush stops there and leaves the rest queued.
+   *
+   * @return false if it stopped early
+   */
+  bool flush ()
+  {
+    while (!queue.empty())
+    {
+      if (!acquire(current, GL_TIMEOUT_IGNORED))
+      {
+        std::cout << "ERROR::TEXTURE_STREAMER::WAIT_FAILED" << std::endl;
+        return false;
+      }
+      stream(segmentBytes);
+    }
+
+    return true;
+  }
+
+  const Stats &getStats () const
+  {
+    return stats;
+  }
+
+  /**
+   * @brief Deletes the ring. Call before destroying the context.
+   */
+  void clear ()
+  {
+    for (Pending &upload : queue)
+    {
+      if (upload.release)
+      {
+        upload.release();
+      }
+    }
+    queue.clear();
+
+    for (unsigned int i = 0; i < SEGMENTS; i++)
+    {
+      if (fences[i])
+      {
+        glDeleteSync(fences[i]);
+        fences[i] = 0;
+      }
+    }
+
+    if (buffers[0])
+    {
+      for (unsigned int i = 0; i < SEGMENTS; i++)
+      {
+        if (persistent)
+        {
+          GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[i]);
+          glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        GLState::instance().deleted(buffers[i]);
+      }
+      GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      glDeleteBuffers(SEGMENTS, buffers);
+      buffers[0] = 0;
+    }
+  }
+
+private:
+  struct Pending
+  {
+    unsigned int texture;
+    int width;
+    int height;
+    GLenum format;
+    size_t rowBytes;
+    const unsigned char *pixels;
+    int nextRow = 0;
+    std::function<void()> release;
+    bool mipmaps;
+  };
+
+  // A band of rows already copied into the current segment
+  struct Band
+  {
+    unsigned int texture;
+    int width;
+    GLenum format;
+    int row;
+    int rows;
+    size_t offset;
+    bool last;
+    bool mipmaps;
+  };
+
+  static int channels (GLenum format)
+  {
+    switch (format)
+    {
+      case GL_RED: return 1;
+      case GL_RG: return 2;
+      case GL_RGB: return 3;
+      default: return 4;
+    }
+  }
+
+  void finish (Pending &upload)
+  {
+    if (upload.mipmaps)
+    {
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    if (upload.release)
+    {
+      upload.release();
+    }
+    stats.textures++;
+  }
+
+  // True once the GPU is done reading the segment
+  bool acquire (unsigned int segment, GLuint64 timeout)
+  {
+    if (!fences[segment])
+    {
+      return true;
+    }
+
+    GLenum status = glClientWaitSync(fences[segment], timeout ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+    {
+      return false;
+    }
+
+    glDeleteSync(fences[segment]);
+    fences[segment] = 0;
+    return true;
+  }
+
+  // The segment must have been acquired: its fence is replaced at the end
+  void stream (size_t limit)
+  {
+    unsigned int segment = current;
+    unsigned char *memory = mapped[segment];
+    std::vector<Band> bands;
+    size_t used = 0;
+
+    GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, buffers[segment]);
+    if (!persistent)
+    {
+      GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+      memory = (unsigned char *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, segmentBytes, flags);
+    }
+
+    while (!queue.empty() && memory)
+    {
+      Pending &upload = queue.front();
+      size_t offset = (used + 15) & ~(size_t)15;
+      size_t space = offset < limit ? limit - offset : 0;
+      int rows = (int)(space / upload.rowBytes);
+
+      // A row larger than the budget still has to go through, alone
+      if (rows == 0 && bands.empty())
+      {
+        offset = 0;
+        rows = 1;
+      }
+      if (rows == 0)
+      {
+        break;
+      }
+      rows = rows < upload.height - upload.nextRow ? rows : upload.height - upload.nextRow;
+
+      size_t bytes = (size_t)rows * upload.rowBytes;
+      memcpy(memory + offset, upload.pixels + (size_t)upload.nextRow * upload.rowBytes, bytes);
+      used = offset + bytes;
+
+      Band band = {upload.texture, upload.width, upload.format, upload.nextRow, rows, offset, false, upload.mipmaps};
+      upload.nextRow += rows;
+      band.last = upload.nextRow == upload.height;
+      bands.push_back(band);
+
+      if (band.last)
+      {
+        if (upload.release)
+        {
+          upload.release();
+        }
+        queue.pop_front();
+      }
+    }
+
+    if (!persistent && memory)
+    {
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (const Band &band : bands)
+    {
+      GLState::instance().bindTexture(0, GL_TEXTURE_2D, band.texture);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, band.row, band.width, band.rows, band.format, GL_UNSIGNED_BYTE, (void *)band.offset);
+
+      if (band.last)
+      {
+        if (band.mipmaps)
+        {
+          glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        stats.textures++;
+      }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Client pointers given to glTexImage2D would otherwise be read as
+    // offsets into the buffer
+    GLState::instance().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // update() polls the fence without the flush bit, so it is flushed
+    // here; otherwise, with no swap in between, it might never be signaled
+    fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    current = (current + 1) % SEGMENTS;
+
+    stats.bytes += used;
+    stats.maxFrameBytes = used > stats.maxFrameBytes ? used : stats.maxFrameBytes;
+  }
+
+  unsigned int buffers[SEGMENTS] = {0};
+  unsigned char *mapped[SEGMENTS];
+  GLsync fences[SEGMENTS];
+  unsigned int current = 0;
+  size_t segmentBytes;
+  size_t budget = 0;
+  bool persistent = false;
+  std::deque<Pending> queue;
+  Stats stats;
+};
+
+#endif
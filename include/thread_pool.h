@@ -0,0 +1,115 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size pool of worker threads.
+ *
+ * Jobs are run in submission order by the first free worker. Workers
+ * never touch OpenGL: anything that needs the context has to be handed
+ * back to the thread that owns it.
+ */
+class ThreadPool
+{
+public:
+  /**
+   * @brief Starts the workers.
+   *
+   * @param count number of workers, defaults to one per hardware thread
+   */
+  explicit ThreadPool (unsigned int count = std::thread::hardware_concurrency())
+  {
+    if (count == 0)
+    {
+      count = 1;
+    }
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+      workers.emplace_back([this] () { run(); });
+    }
+  }
+
+  ~ThreadPool ()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    condition.notify_all();
+
+    for (std::thread &worker : workers)
+    {
+      worker.join();
+    }
+  }
+
+  ThreadPool (const ThreadPool &) = delete;
+  ThreadPool &operator= (const ThreadPool &) = delete;
+
+  /**
+   * @brief Queues a job.
+   *
+   * @return std::future with the result of the job
+   */
+  template <typename F>
+  auto submit (F job) -> std::future<decltype(job())>
+  {
+    using Result = decltype(job());
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::move(job));
+    std::future<Result> result = task->get_future();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobs.emplace_back([task] () { (*task)(); });
+    }
+    condition.notify_one();
+
+    return result;
+  }
+
+  unsigned int size () const
+  {
+    return (unsigned int)workers.size();
+  }
+
+private:
+  void run ()
+  {
+    for (;;)
+    {
+      std::function<void()> job;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] () { return stopping || !jobs.empty(); });
+
+        if (jobs.empty())
+        {
+          return;
+        }
+
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+
+      job();
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> jobs;
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool stopping = false;
+};
+
+#endif
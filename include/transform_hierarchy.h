@@ -0,0 +1,349 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Parent-child transforms of scene objects, stored as arrays.
+ *
+ *   TransformHierarchy scene;
+ *   TransformHierarchy::Node car = scene.create();
+ *   TransformHierarchy::Node wheel = scene.create(car, glm::vec3(1.0f, 0.0f, 0.0f));
+ *
+ *   scene.setRotation(wheel, glm::angleAxis(time, glm::vec3(1.0f, 0.0f, 0.0f)));
+ *   scene.update();
+ *   instances.update(scene.worlds(), scene.size());  // CubeInstances
+ *
+ * The local position, rotation and scale of every node live in one array
+ * each, next to the slot of its parent and a dirty flag, so a pass over
+ * the nodes reads memory in order. The slots are sorted by depth (roots
+ * first, then their children, and so on), so a parent is always updated
+ * before its children and update() is a single loop with no recursion.
+ *
+ * Setting a local transform only marks its node dirty. update() then
+ * recomputes the world matrix of the dirty nodes and of everything under
+ * them, and leaves the rest as it was. The world matrices are written to
+ * one contiguous array, in slot order, that can be copied as is into an
+ * instance buffer; nodeAt() tells which node each matrix belongs to.
+ *
+ * Nodes are referred to by the handle create() returns, which stays the
+ * same when the slots are sorted again after create() or setParent().
+ */
+class TransformHierarchy
+{
+public:
+  typedef uint32_t Node;
+
+  static constexpr Node NONE = 0xffffffffu;
+
+  /**
+   * @brief Adds a node.
+   *
+   * @param parent its parent, or NONE for a root
+   *
+   * @return the handle of the node
+   */
+  Node create (Node parent = NONE, const glm::vec3 &position = glm::vec3(0.0f),
+               const glm::quat &rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3 &scale = glm::vec3(1.0f))
+  {
+    Node node = (Node)slots.size();
+    uint32_t slot = (uint32_t)positions.size();
+    uint32_t depth = parent == NONE ? 0 : depths[slots[parent]] + 1;
+
+    // Still sorted as long as no node is shallower than the last one
+    sorted = sorted && (slot == 0 || depth >= depths[slot - 1]);
+
+    slots.push_back(slot);
+    nodes.push_back(node);
+    positions.push_back(position);
+    rotations.push_back(rotation);
+    scales.push_back(scale);
+    parents.push_back(parent == NONE ? NONE : slots[parent]);
+    depths.push_back(depth);
+    dirty.push_back(1);
+    worldMatrices.push_back(glm::mat4(1.0f));
+    pending = true;
+
+    return node;
+  }
+
+  /**
+   * @brief Moves a node, and everything under it, to another parent.
+   *
+   * @param parent the new parent, or NONE; not the node itself nor
+   *   anything under it
+   */
+  void setParent (Node node, Node parent)
+  {
+    uint32_t slot = slots[node];
+
+    parents[slot] = parent == NONE ? NONE : slots[parent];
+    dirty[slot] = 1;
+    sorted = false;
+    pending = true;
+  }
+
+  void setPosition (Node node, const glm::vec3 &position)
+  {
+    positions[slots[node]] = position;
+    touch(node);
+  }
+
+  void setRotation (Node node, const glm::quat &rotation)
+  {
+    rotations[slots[node]] = rotation;
+    touch(node);
+  }
+
+  void setScale (Node node, const glm::vec3 &scale)
+  {
+    scales[slots[node]] = scale;
+    touch(node);
+  }
+
+  const glm::vec3 &getPosition (Node node) const
+  {
+    return positions[slots[node]];
+  }
+
+  const glm::quat &getRotation (Node node) const
+  {
+    return rotations[slots[node]];
+  }
+
+  const glm::vec3 &getScale (Node node) const
+  {
+    return scales[slots[node]];
+  }
+
+  Node getParent (Node node) const
+  {
+    uint32_t parent = parents[slots[node]];
+    return parent == NONE ? NONE : nodes[parent];
+  }
+
+  /**
+   * @brief Recomputes the world matrices that changed.
+   *
+   * @return number of world matrices recomputed
+   */
+  size_t update ()
+  {
+    size_t count = positions.size(), recomputed = 0;
+
+    if (!pending)
+    {
+      return 0;
+    }
+
+    if (!sorted)
+    {
+      sort();
+    }
+
+    uint8_t *flags = dirty.data();
+    for (size_t slot = 0; slot < count; slot++)
+    {
+      uint32_t parent = parents[slot];
+
+      if (!flags[slot] && (parent == NONE || !flags[parent]))
+      {
+        continue;
+      }
+
+      glm::mat4 local = compose(positions[slot], rotations[slot], scales[slot]);
+      worldMatrices[slot] = parent == NONE ? local : multiply(worldMatrices[parent], local);
+      flags[slot] = 1;
+      recomputed++;
+    }
+
+    std::memset(flags, 0, count);
+    pending = false;
+
+    return recomputed;
+  }
+
+  /**
+   * @brief World matrix of a node, as of the last update().
+   */
+  const glm::mat4 &getWorld (Node node) const
+  {
+    return worldMatrices[slots[node]];
+  }
+
+  /**
+   * @brief The world matrices of all the nodes, size() of them, in slot
+   * order.
+   */
+  const glm::mat4 *worlds () const
+  {
+    return worldMatrices.data();
+  }
+
+  // Node whose matrix is worlds()[slot]
+  Node nodeAt (size_t slot) const
+  {
+    return nodes[slot];
+  }
+
+  size_t size () const
+  {
+    return positions.size();
+  }
+
+  void clear ()
+  {
+    slots.clear();
+    nodes.clear();
+    positions.clear();
+    rotations.clear();
+    scales.clear();
+    parents.clear();
+    depths.clear();
+    dirty.clear();
+    worldMatrices.clear();
+    sorted = true;
+    pending = false;
+  }
+
+private:
+  // Indexed by handle
+  std::vector<uint32_t> slots;
+
+  // Indexed by slot
+  std::vector<Node> nodes;
+  std::vector<glm::vec3> positions;
+  std::vector<glm::quat> rotations;
+  std::vector<glm::vec3> scales;
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> depths;
+  std::vector<uint8_t> dirty;
+  std::vector<glm::mat4> worldMatrices;
+
+  bool sorted = true;
+  bool pending = false;
+
+  void touch (Node node)
+  {
+    dirty[slots[node]] = 1;
+    pending = true;
+  }
+
+  // translate(position) * mat4_cast(rotation) * scale(scale), written out
+  static glm::mat4 compose (const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale)
+  {
+    float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+    glm::mat4 matrix;
+
+    matrix[0] = glm::vec4((1.0f - 2.0f * (y * y + z * z)) * scale.x, 2.0f * (x * y + w * z) * scale.x, 2.0f * (x * z - w * y) * scale.x, 0.0f);
+    matrix[1] = glm::vec4(2.0f * (x * y - w * z) * scale.y, (1.0f - 2.0f * (x * x + z * z)) * scale.y, 2.0f * (y * z + w * x) * scale.y, 0.0f);
+    matrix[2] = glm::vec4(2.0f * (x * z + w * y) * scale.z, 2.0f * (y * z - w * x) * scale.z, (1.0f - 2.0f * (x * x + y * y)) * scale.z, 0.0f);
+    matrix[3] = glm::vec4(position, 1.0f);
+
+    return matrix;
+  }
+
+  // parent * local for two affine matrices: the last rows are (0, 0, 0, 1)
+  static glm::mat4 multiply (const glm::mat4 &parent, const glm::mat4 &local)
+  {
+    glm::mat4 result;
+
+    for (int column = 0; column < 3; column++)
+    {
+      result[column] = parent[0] * local[column].x + parent[1] * local[column].y + parent[2] * local[column].z;
+    }
+    result[3] = parent[0] * local[3].x + parent[1] * local[3].y + parent[2] * local[3].z + parent[3];
+
+    return result;
+  }
+
+  // Puts the slots back in depth order (a stable counting sort), after
+  // nodes were added above existing ones or moved to other parents
+  void sort ()
+  {
+    size_t count = positions.size();
+    std::vector<uint32_t> depth(count, NONE), order(count), chain;
+    uint32_t deepest = 0;
+
+    // Depths from the parents, which may now come after their children
+    for (size_t slot = 0; slot < count; slot++)
+    {
+      uint32_t current = (uint32_t)slot;
+
+      chain.clear();
+      while (depth[current] == NONE && parents[current] != NONE)
+      {
+        chain.push_back(current);
+        current = parents[current];
+      }
+      if (depth[current] == NONE)
+      {
+        depth[current] = 0;
+      }
+      for (size_t i = chain.size(); i-- > 0; )
+      {
+        depth[chain[i]] = depth[parents[chain[i]]] + 1;
+      }
+      deepest = std::max(deepest, depth[slot]);
+    }
+
+    std::vector<uint32_t> starts(deepest + 2, 0);
+    for (uint32_t d : depth)
+    {
+      starts[d + 1]++;
+    }
+    for (uint32_t d = 0; d <= deepest; d++)
+    {
+      starts[d + 1] += starts[d];
+    }
+
+    // order[new slot] = old slot
+    std::vector<uint32_t> moved(count);
+    for (size_t slot = 0; slot < count; slot++)
+    {
+      uint32_t to = starts[depth[slot]]++;
+      order[to] = (uint32_t)slot;
+      moved[slot] = to;
+    }
+
+    permute(nodes, order);
+    permute(positions, order);
+    permute(rotations, order);
+    permute(scales, order);
+    permute(dirty, order);
+    permute(worldMatrices, order);
+    permute(parents, order);
+    for (uint32_t &parent : parents)
+    {
+      parent = parent == NONE ? NONE : moved[parent];
+    }
+    for (size_t slot = 0; slot < count; slot++)
+    {
+      depths[slot] = depth[order[slot]];
+      slots[nodes[slot]] = (uint32_t)slot;
+    }
+
+    sorted = true;
+  }
+
+  template <typename T>
+  static void permute (std::vector<T> &values, const std::vector<uint32_t> &order)
+  {
+    std::vector<T> permuted;
+
+    permuted.reserve(values.size());
+    for (uint32_t from : order)
+    {
+      permuted.push_back(values[from]);
+    }
+    values.swap(permuted);
+  }
+};
+
+#endif
@@ -0,0 +1,384 @@
+#ifndef UNIFORM_CACHE_H
+#define UNIFORM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Hashes a uniform name using 64-bit FNV-1a.
+ *
+ * It is constexpr so names written as literals can be hashed by the
+ * compiler instead of at every call.
+ *
+ * @param name the null-terminated uniform name
+ *
+ * @return uint64_t the hash of the name
+ */
+constexpr uint64_t uniform_hash (const char *name)
+{
+  uint64_t hash = 14695981039346656037ull;
+
+  while (*name)
+  {
+    hash ^= static_cast<uint8_t>(*name++);
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+/**
+ * @brief Interned key for a uniform.
+ *
+ * Stores the hash of the name along with a pointer to the name itself
+ * (only used when the cache must fall back to the driver). Literals and
+ * std::string convert implicitly, so existing calls like
+ * setMat4("model", ...) keep working without building a std::string.
+ *
+ * For the hottest paths the key can be declared once and reused:
+ *
+ *   constexpr UniformName U_MODEL("model");
+ *   shader.setMat4(U_MODEL, model);
+ */
+struct UniformName
+{
+  uint64_t hash;
+  const char *str;
+
+  constexpr UniformName (const char *name) : hash(uniform_hash(name)), str(name) {}
+
+  UniformName (const std::string &name) : hash(uniform_hash(name.c_str())), str(name.c_str()) {}
+};
+
+/**
+ * @brief Name to location table of the active uniforms of a program.
+ *
+ * The table is filled once after linking by enumerating the active uni-
+ * forms with glGetActiveUniform. It is a flat, open addressed array of
+ * (hash, location) pairs, so a lookup touches one or two cache lines and
+ * never calls the driver.
+ */
+class UniformCache
+{
+public:
+  // Location stored for names whose hash collides with another name
+  static const GLint COLLISION = -2;
+
+  /**
+   * @brief Enumerates the active uniforms of a linked program.
+   *
+   * Arrays are registered both by their base name ("lights") and by each
+   * of their elements ("lights[0]", "lights[1]", ...).
+   *
+   * @param _program the linked program to inspect
+   */
+  void build (GLuint _program)
+  {
+    GLint count = 0, maxLength = 0;
+    std::vector<std::pair<std::string, GLint>> entries;
+
+    program = _program;
+    slots.clear();
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+
+    for (GLint i = 0; i < count; i++)
+    {
+      GLint size;
+      GLenum type;
+      GLsizei length;
+
+      glGetActiveUniform(program, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+
+      std::string name(buffer.data(), length);
+      GLint location = glGetUniformLocation(program, name.c_str());
+
+      // Members of uniform blocks have no location
+      if (location < 0)
+      {
+        continue;
+      }
+
+      entries.emplace_back(name, location);
+
+      // Arrays are reported as "name[0]", register every element too
+      std::string::size_type bracket = name.rfind("[0]");
+      if (bracket != std::string::npos && bracket + 3 == name.size())
+      {
+        std::string base = name.substr(0, bracket);
+        entries.emplace_back(base, location);
+
+        for (GLint j = 1; j < size; j++)
+        {
+          std::string element = base + "[" + std::to_string(j) + "]";
+          GLint elementLocation = glGetUniformLocation(program, element.c_str());
+
+          if (elementLocation >= 0)
+          {
+            entries.emplace_back(element, elementLocation);
+          }
+        }
+      }
+    }
+
+    // Keep the load factor under 50% so probes stay short
+    size_t capacity = 8;
+    while (capacity < entries.size() * 2)
+    {
+      capacity <<= 1;
+    }
+
+    slots.assign(capacity, Slot{0, EMPTY});
+    mask = capacity - 1;
+
+    for (const auto &entry : entries)
+    {
+      insert(uniform_hash(entry.first.c_str()), entry.second);
+    }
+  }
+
+  /**
+   * @brief Returns the location of a uniform.
+   *
+   * @param name the key of the uniform
+   *
+   * @return GLint the location, or -1 if the uniform is not active (the
+   *   same value glGetUniformLocation would return)
+   */
+  GLint find (const UniformName &name) const
+  {
+    if (slots.empty())
+    {
+      return glGetUniformLocation(program, name.str);
+    }
+
+    for (size_t i = name.hash & mask; ; i = (i + 1) & mask)
+    {
+      const Slot &slot = slots[i];
+
+      if (slot.location == EMPTY)
+      {
+        return -1;
+      }
+
+      if (slot.hash == name.hash)
+      {
+        return slot.location == COLLISION ? glGetUniformLocation(program, name.str) : slot.location;
+      }
+    }
+  }
+
+  /**
+   * @brief Copies the current values of every uniform from one program
+   * into another, e.g. when a program is rebuilt after a hot reload.
+   *
+   * Only uniforms present in both programs with the same type are copied,
+   * and only types copyValue() knows (not image or double types).
+   * Leaves the previously bound program bound.
+   */
+  static void copyValues (GLuint from, GLuint to)
+  {
+    GLint count = 0, maxLength = 0, previous = 0;
+    std::map<std::string, GLenum> targetTypes;
+
+    glGetProgramiv(to, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(to, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+
+    for (GLint i = 0; i < count; i++)
+    {
+      GLint size;
+      GLenum type;
+      GLsizei length;
+
+      glGetActiveUniform(to, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+      targetTypes[std::string(buffer.data(), length)] = type;
+    }
+
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+    glUseProgram(to);
+
+    glGetProgramiv(from, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(from, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    buffer.resize(maxLength > 0 ? maxLength : 1);
+
+    for (GLint i = 0; i < count; i++)
+    {
+      GLint size;
+      GLenum type;
+      GLsizei length;
+
+      glGetActiveUniform(from, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+
+      std::string name(buffer.data(), length);
+      auto target = targetTypes.find(name);
+
+      if (target == targetTypes.end() || target->second != type)
+      {
+        continue;
+      }
+
+      // Arrays are reported as "name[0]", copy each element
+      std::string base = name;
+      if (size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+      {
+        base = name.substr(0, name.size() - 3);
+      }
+
+      for (GLint j = 0; j < size; j++)
+      {
+        std::string element = size > 1 ? base + "[" + std::to_string(j) + "]" : name;
+        GLint source = glGetUniformLocation(from, element.c_str());
+        GLint destination = glGetUniformLocation(to, element.c_str());
+
+        if (source >= 0 && destination >= 0)
+        {
+          copyValue(type, from, source, destination);
+        }
+      }
+    }
+
+    glUseProgram(previous);
+  }
+
+  /**
+   * @brief Returns the number of names registered in the table.
+   */
+  size_t size () const
+  {
+    size_t count = 0;
+
+    for (const Slot &slot : slots)
+    {
+      count += slot.location != EMPTY;
+    }
+
+    return count;
+  }
+
+private:
+  static const GLint EMPTY = -1;
+
+  // Copies one uniform into the currently bound program. Types with no
+  // case here are skipped rather than guessed at
+  static void copyValue (GLenum type, GLuint from, GLint source, GLint destination)
+  {
+    GLfloat f[16];
+    GLint i[4];
+    GLuint u[4];
+
+    switch (type)
+    {
+      case GL_FLOAT:             glGetUniformfv(from, source, f); glUniform1fv(destination, 1, f); break;
+      case GL_FLOAT_VEC2:        glGetUniformfv(from, source, f); glUniform2fv(destination, 1, f); break;
+      case GL_FLOAT_VEC3:        glGetUniformfv(from, source, f); glUniform3fv(destination, 1, f); break;
+      case GL_FLOAT_VEC4:        glGetUniformfv(from, source, f); glUniform4fv(destination, 1, f); break;
+      case GL_FLOAT_MAT2:        glGetUniformfv(from, source, f); glUniformMatrix2fv(destination, 1, GL_FALSE, f); break;
+      case GL_FLOAT_MAT3:        glGetUniformfv(from, source, f); glUniformMatrix3fv(destination, 1, GL_FALSE, f); break;
+      case GL_FLOAT_MAT4:        glGetUniformfv(from, source, f); glUniformMatrix4fv(destination, 1, GL_FALSE, f); break;
+      case GL_FLOAT_MAT2x3:      glGetUniformfv(from, source, f); glUniformMatrix2x3fv(destination, 1, GL_FALSE, f); break;
+      case GL_FLOAT_MAT2x4:      glGetUniformfv(from, source, f); glUniformMatrix2x4fv(destination, 1, GL_FALSE, f); break;
+      case GL_FLOAT_MAT3x2:      glGetUniformfv(from, source, f); glUniformMatrix3x2fv(destination, 1, GL_FALSE, f); break;
+      case GL_FLOAT_MAT3x4:      glGetUniformfv(from, source, f); glUniformMatrix3x4fv(destination, 1, GL_FALSE, f); break;
+      case GL_FLOAT_MAT4x2:      glGetUniformfv(from, source, f); glUniformMatrix4x2fv(destination, 1, GL_FALSE, f); break;
+      case GL_FLOAT_MAT4x3:      glGetUniformfv(from, source, f); glUniformMatrix4x3fv(destination, 1, GL_FALSE, f); break;
+      case GL_INT_VEC2:
+      case GL_BOOL_VEC2:         glGetUniformiv(from, source, i); glUniform2iv(destination, 1, i); break;
+      case GL_INT_VEC3:
+      case GL_BOOL_VEC3:         glGetUniformiv(from, source, i); glUniform3iv(destination, 1, i); break;
+      case GL_INT_VEC4:
+      case GL_BOOL_VEC4:         glGetUniformiv(from, source, i); glUniform4iv(destination, 1, i); break;
+      case GL_UNSIGNED_INT:      glGetUniformuiv(from, source, u); glUniform1uiv(destination, 1, u); break;
+      case GL_UNSIGNED_INT_VEC2: glGetUniformuiv(from, source, u); glUniform2uiv(destination, 1, u); break;
+      case GL_UNSIGNED_INT_VEC3: glGetUniformuiv(from, source, u); glUniform3uiv(destination, 1, u); break;
+      case GL_UNSIGNED_INT_VEC4: glGetUniformuiv(from, source, u); glUniform4uiv(destination, 1, u); break;
+      case GL_INT:
+      case GL_BOOL:
+      case GL_SAMPLER_1D:
+      case GL_SAMPLER_2D:
+      case GL_SAMPLER_3D:
+      case GL_SAMPLER_CUBE:
+      case GL_SAMPLER_1D_SHADOW:
+      case GL_SAMPLER_2D_SHADOW:
+      case GL_SAMPLER_1D_ARRAY:
+      case GL_SAMPLER_2D_ARRAY:
+      case GL_SAMPLER_1D_ARRAY_SHADOW:
+      case GL_SAMPLER_2D_ARRAY_SHADOW:
+      case GL_SAMPLER_2D_MULTISAMPLE:
+      case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+      case GL_SAMPLER_CUBE_SHADOW:
+      case GL_SAMPLER_BUFFER:
+      case GL_SAMPLER_2D_RECT:
+      case GL_SAMPLER_2D_RECT_SHADOW:
+      case GL_INT_SAMPLER_1D:
+      case GL_INT_SAMPLER_2D:
+      case GL_INT_SAMPLER_3D:
+      case GL_INT_SAMPLER_CUBE:
+      case GL_INT_SAMPLER_1D_ARRAY:
+      case GL_INT_SAMPLER_2D_ARRAY:
+      case GL_INT_SAMPLER_2D_MULTISAMPLE:
+      case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+      case GL_INT_SAMPLER_BUFFER:
+      case GL_INT_SAMPLER_2D_RECT:
+      case GL_UNSIGNED_INT_SAMPLER_1D:
+      case GL_UNSIGNED_INT_SAMPLER_2D:
+      case GL_UNSIGNED_INT_SAMPLER_3D:
+      case GL_UNSIGNED_INT_SAMPLER_CUBE:
+      case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+      case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+      case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+      case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+      case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+      case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+        // A single integer (the texture unit, for samplers)
+        glGetUniformiv(from, source, i);
+        glUniform1iv(destination, 1, i);
+        break;
+      default:
+        break;
+    }
+  }
+
+  struct Slot
+  {
+    uint64_t hash;
+    GLint location;
+  };
+
+  void insert (uint64_t hash, GLint location)
+  {
+    for (size_t i = hash & mask; ; i = (i + 1) & mask)
+    {
+      Slot &slot = slots[i];
+
+      if (slot.location == EMPTY)
+      {
+        slot = Slot{hash, location};
+        return;
+      }
+
+      // Two names with the same hash: let the driver resolve both
+      if (slot.hash == hash)
+      {
+        if (slot.location != location)
+        {
+          slot.location = COLLISION;
+        }
+        return;
+      }
+    }
+  }
+
+  std::vector<Slot> slots;
+  size_t mask = 0;
+  GLuint program = 0;
+};
+
+#endif
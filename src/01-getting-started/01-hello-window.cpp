@@ -1,6 +1,7 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 
 void framebuffer_size_callback (GLFWwindow* window, int width, int height);
 
@@ -30,11 +31,11 @@ void processInput (GLFWwindow* window);
  * 
  * @return int 
  */
-int main ()
+int main (int argc, char **argv)
 {
   // Inicializa la librería GLFW, que nos permite utilizar las funciones
   // glfw*
-  glfwInit();
+  Headless::instance().init(argc, argv);
 
   // Configura la ventana creada por GFWL para usar la versión 3.3 de
   // OpenGL, en modo Core-Profile (lanza errores si se usan funciones
@@ -64,6 +65,7 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
 
   // Establece el tamaño del espacio de renderizado igual al de la 
   // ventana que creamos previamente.
@@ -102,6 +104,7 @@ int main ()
     // back buffer al front buffer (que es el que despliega la ventana)
     // para iniciar con el procesamiento del frame siguiente.
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
   }
 
   // Libera los recursos de la aplicación antes de salir.
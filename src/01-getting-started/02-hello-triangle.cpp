@@ -1,6 +1,7 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 
 void framebuffer_size_callback (GLFWwindow* window, int width, int height);
 void processInput (GLFWwindow* window);
@@ -51,7 +52,7 @@ const char *fragmentShaderSource = "#version 330 core\n"
   "  FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
   "}\0";
 
-int main ()
+int main (int argc, char **argv)
 {
   /**
    * Coordenadas del triángulo a dibujar.
@@ -122,7 +123,7 @@ int main ()
 
   // -------------------------------------------------------------------
   // Inicialización de glfw (explicado en el programa anterior)
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -140,6 +141,7 @@ int main ()
     glfwTerminate();
     return -1;    
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, 800, 600);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
   // Fin del código de inicialización
@@ -337,6 +339,7 @@ int main ()
 
     // Intercambia buffers y procesa eventos I/O
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
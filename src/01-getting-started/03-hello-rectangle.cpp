@@ -1,6 +1,7 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void process_input(GLFWwindow* window);
@@ -37,7 +38,7 @@ const char* vertexShaderSource = "#version 330 core\n"
  * 
  * @return int 
  */
-int main ()
+int main (int argc, char **argv)
 {
   // -------------------------------------------------------------------
   // Definición de variables
@@ -74,7 +75,7 @@ int main ()
   // -------------------------------------------------------------------
   // Inicialización de glfw
   // -------------------------------------------------------------------
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -94,6 +95,7 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
 
   glViewport(0, 0, 800, 600);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
@@ -197,6 +199,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
   // -------------------------------------------------------------------
@@ -2,6 +2,7 @@
 #include <math.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
 void process_input (GLFWwindow *window);
@@ -21,7 +22,7 @@ const char *vertexShaderSource = "#version 330 core\n"
   "  gl_Position = vec4(aPos, 1.0);\n"  
   "}\0";
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   char infoLog[512];
@@ -37,7 +38,7 @@ int main ()
   GLFWwindow *window;
 
   // Inicialización
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -57,6 +58,7 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, 800, 600);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
@@ -130,6 +132,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents(); 
   }
 
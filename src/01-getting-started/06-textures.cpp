@@ -1,6 +1,7 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 #include "../../include/shader_s.h"
 
 /**
@@ -9,7 +10,6 @@
  * Esta librería permite cargar los formatos de imágenes más populares
  * de manera fácil.
  */
-#define STB_IMAGE_IMPLEMENTATION
 #include "../../include/stb_image.h"
 
 const int SCREEN_WIDTH = 800;
@@ -18,7 +18,7 @@ const int SCREEN_HEIGHT = 600;
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
 void process_input (GLFWwindow *window);
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   int width, height, channels;
@@ -38,7 +38,7 @@ int main ()
   GLFWwindow *window;
 
   // Inicialización
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -59,6 +59,7 @@ int main ()
     std::cout << "Error al inicializar GLAD" << std::endl;
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 
   // Genera un objeto textura y lo vincula para trabajar con él
@@ -248,6 +249,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
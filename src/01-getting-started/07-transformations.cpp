@@ -1,12 +1,12 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <headless.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <shader_s.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
@@ -15,7 +15,7 @@ void process_input (GLFWwindow *window);
 const int WINDOW_HEIGHT = 600;
 const int WINDOW_WIDTH = 800;
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   int channels, height, width;
@@ -37,7 +37,7 @@ int main ()
 
   // Inicialización
   // -------------------------------------------------------------------
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -58,6 +58,7 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
 
   // Buffers
@@ -155,6 +156,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
@@ -2,12 +2,12 @@
 #include <math.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <headless.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <shader_s.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 const int WINDOW_HEIGHT = 600;
@@ -16,7 +16,7 @@ const int WINDOW_WIDTH = 800;
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
 void process_input (GLFWwindow *window);
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   // -------------------------------------------------------------------
@@ -77,7 +77,7 @@ int main ()
 
   // Inicialización
   // -------------------------------------------------------------------
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -98,6 +98,7 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
   glEnable(GL_DEPTH_TEST);
 
@@ -244,6 +245,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
@@ -1,12 +1,12 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <headless.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <shader_s.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 void drawCube (unsigned int shaderId);
@@ -26,7 +26,7 @@ float lastY = SCREEN_WIDTH / 2;
 float pitch = 0.0f;
 float yaw = 0.0f;
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   // -------------------------------------------------------------------
@@ -68,7 +68,7 @@ int main ()
 
   // Inicialización
   // -------------------------------------------------------------------
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -91,6 +91,7 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
   glEnable(GL_DEPTH_TEST);
 
@@ -219,6 +220,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
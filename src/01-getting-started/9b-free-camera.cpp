@@ -1,7 +1,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <headless.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include <glm/glm.hpp>
@@ -36,9 +36,9 @@ float fov = 45.0f;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main ()
+int main (int argc, char **argv)
 {
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -67,6 +67,7 @@ int main ()
     std::cout << "Error al cargar las funciones de OpenGL" << std::endl;
     return -1;
   }
+  Headless::instance().attach(window);
 
   glEnable (GL_DEPTH_TEST);
   Shader ourShader("../shaders/coord-system.vs.glsl", "../shaders/texture.fs.glsl");
@@ -228,6 +229,7 @@ int main ()
     }
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
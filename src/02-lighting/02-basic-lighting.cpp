@@ -1,6 +1,7 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <headless.h>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -24,7 +25,7 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   float currentFrame;
@@ -52,7 +53,7 @@ int main ()
   glm::vec3 lightPos = glm::vec3(1.2f, 1.0f, 2.0f);
 
   // Inicialización
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -76,8 +77,10 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
   glEnable(GL_DEPTH_TEST);
+  camera.SetAspect((float)SCR_WIDTH / (float)SCR_HEIGHT);
 
   // Buffers
   glGenVertexArrays(2, VAO);
@@ -130,11 +133,7 @@ int main ()
 
     model = glm::mat4(1.0f);
     view = camera.GetViewMatrix();
-    projection = glm::perspective(
-      glm::radians(camera.Zoom),
-      (float)SCR_WIDTH / (float)SCR_HEIGHT, 
-      0.1f, 100.0f
-    );
+    projection = camera.GetProjectionMatrix();
 
     objectShader.use();
     objectShader.setMat4("model", model);
@@ -155,6 +154,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
@@ -172,6 +172,12 @@ int main ()
 void framebuffer_size_callback (GLFWwindow *window, int width, int height)
 {
   glViewport(0, 0, width, height);
+
+  // A minimized window is 0x0
+  if (width > 0 && height > 0)
+  {
+    camera.SetAspect((float)width / (float)height);
+  }
 }
 
 void mouse_callback (GLFWwindow *window, double xPosIn, double yPosIn)
@@ -1,12 +1,19 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <headless.h>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cpu_tracer.h>
+#include <frame_uniforms.h>
+#include <gl_state.h>
+#include <gpu_profiler.h>
+#include <shader_hot_reload.h>
 #include <shader_s.h>
+#include <shader_variants.h>
 #include "../../include/camera.h"
 
 const int SCR_HEIGHT = 600;
@@ -18,13 +25,16 @@ void process_input (GLFWwindow *window);
 void scroll_callback (GLFWwindow *window, double xOffset, double yOffset);
 
 bool firstMouse = true;
+bool specular = true;
+bool variantChanged = true;
+float shininess = 128.0f;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 
-int main ()
+int main (int argc, char **argv)
 {
   float currentFrame;
   float vertices[] = {
@@ -72,10 +82,10 @@ int main ()
   };
   unsigned int VBO, VAO[2];
   GLFWwindow *window;
-  glm::mat4 lightModel, model, view, projection;
+  glm::mat4 lightModel, model;
   glm::vec3 lightPos = glm::vec3(1.2f, 1.0f, 2.0f);
 
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -99,8 +109,13 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
   glEnable(GL_DEPTH_TEST);
+  camera.SetAspect((float)SCR_WIDTH / (float)SCR_HEIGHT);
+
+  // Reuse the linked programs of previous runs to cut startup time
+  ProgramCache::instance().enable("shader-cache", (GLADloadproc)glfwGetProcAddress);
 
   glGenVertexArrays(2, VAO);
   glGenBuffers(1, &VBO);
@@ -121,59 +136,122 @@ int main ()
   glBindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-  Shader objectShader("../shaders/textureless.vs.glsl", "../shaders/textureless.fs.glsl");
-  Shader lightShader("../shaders/light.vs.glsl", "../shaders/light.fs.glsl");
+  // Edited shader files are rebuilt on a hidden window's context, which
+  // shares programs with the main one, and swapped in between frames
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  GLFWwindow *reloadContext = glfwCreateWindow(1, 1, "Shader reload", NULL, window);
+  ShaderHotReload hotReload([reloadContext] () { glfwMakeContextCurrent(reloadContext); },
+                            [] () { glfwMakeContextCurrent(NULL); });
+
+  // Specular on/off (Z/X) and shininess 32/128 (1/2) are compile-time
+  // permutations of the object shader, built on first use
+  ShaderVariants objectVariants("../shaders/textureless.vs.glsl", "../shaders/textureless.fs.glsl");
+  Shader *objectShader = NULL;
+  Shader lightShader("../shaders/light.vs.glsl", "../shaders/light.fs.glsl", FrameUniforms::DEFINE);
 
-  objectShader.use();
-  objectShader.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
-  objectShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
-  objectShader.setVec3("lightPos", lightPos);
+  objectVariants.setHotReload(&hotReload);
+  hotReload.watch(lightShader, "../shaders/light.vs.glsl", "../shaders/light.fs.glsl", FrameUniforms::DEFINE);
+
+  // View, projection and camera position are written into a uniform
+  // buffer that both programs read, only when the camera changed
+  FrameUniforms frame;
+  lightShader.bindUniformBlock(FrameUniforms::BLOCK, FrameUniforms::BINDING);
 
   lightModel = glm::mat4(1.0f);
   lightModel = glm::translate(lightModel, lightPos);
   lightModel = glm::scale(lightModel, glm::vec3(0.2f));
 
+  PROFILE_CPU_THREAD("main");
+
   while (!glfwWindowShouldClose(window))
   {
+    PROFILE_CPU("frame");
     currentFrame = static_cast<float>(glfwGetTime());
     deltaTime = currentFrame - lastFrame;
     lastFrame = currentFrame;
 
-    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);    
-    process_input(window);
+    GpuProfiler::instance().beginFrame();
 
-    model = glm::mat4(1.0f);
-    view = camera.GetViewMatrix();
-    projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    
-    objectShader.use();
-    objectShader.setMat4("model", model);
-    objectShader.setMat4("view", view);
-    objectShader.setMat4("projection", projection);
-    objectShader.setVec3("viewPos", camera.Position);
+    {
+      PROFILE_GPU("clear");
+      glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    process_input(window);
+    hotReload.apply();
+
+    {
+      PROFILE_CPU("matrices");
+      model = glm::mat4(1.0f);
+    }
+    {
+      PROFILE_CPU("frame-uniforms");
+      frame.update(camera.GetViewMatrix(), camera.GetProjectionMatrix(), camera.Position, currentFrame, camera.GetVersion());
+    }
     
-    glBindVertexArray(VAO[0]);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
-
-    lightShader.use();
-    lightShader.setMat4("model", lightModel);
-    lightShader.setMat4("view", view);
-    lightShader.setMat4("projection", projection);
-
-    glBindVertexArray(VAO[1]);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
-
-    glfwSwapBuffers(window);
+    if (variantChanged)
+    {
+      ShaderDefines defines;
+      defines.set("SPECULAR", specular ? "1" : "0").set("SHININESS", shininess).set("FRAME_UNIFORMS");
+
+      objectShader = &objectVariants.get(defines);
+      objectShader->bindUniformBlock(FrameUniforms::BLOCK, FrameUniforms::BINDING);
+      objectShader->use();
+      objectShader->setVec3("objectColor", 1.0f, 0.5f, 0.31f);
+      objectShader->setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+      objectShader->setVec3("lightPos", lightPos);
+      variantChanged = false;
+    }
+
+    {
+      PROFILE_GPU("lighting-pass");
+      PROFILE_CPU("lighting-pass");
+      objectShader->use();
+      objectShader->setMat4("model", model);
+
+      GLState::instance().bindVertexArray(VAO[0]);
+      glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+    {
+      PROFILE_GPU("light-cube");
+      PROFILE_CPU("light-cube");
+      lightShader.use();
+      lightShader.setMat4("model", lightModel);
+
+      GLState::instance().bindVertexArray(VAO[1]);
+      glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+    GpuProfiler::instance().endFrame();
+
+    {
+      PROFILE_CPU("glfwSwapBuffers");
+      glfwSwapBuffers(window);
+    }
+    Headless::instance().frame(window);
     glfwPollEvents();
+    GLState::instance().endFrame();
   }
-  
+
+  // No rebuild past this point; the watcher thread lets go of the hidden
+  // context before it is destroyed
+  hotReload.stop();
+
+  ProgramCache::instance().report();
+  GLState::instance().report();
+  GpuProfiler::instance().report();
+  GpuProfiler::instance().writeTrace("gpu-trace.json");
+  GpuProfiler::instance().clear();
+  CpuTracer::instance().writeTrace("cpu-trace.json");
+  objectVariants.report();
+  objectVariants.clear();
+  hotReload.unwatch(lightShader);
   lightShader.clear();
-  objectShader.clear();
+  frame.clear();
   glDeleteBuffers(1, &VBO);
   glDeleteVertexArrays(2, VAO);
+  glfwDestroyWindow(reloadContext);
   glfwTerminate();
 
   return 0;
@@ -182,6 +260,12 @@ int main ()
 void framebuffer_size_callback (GLFWwindow *window, int width, int height)
 {
   glViewport(0, 0, width, height);
+
+  // A minimized window is 0x0
+  if (width > 0 && height > 0)
+  {
+    camera.SetAspect((float)width / (float)height);
+  }
 }
 
 void mouse_callback (GLFWwindow *window, double xPosIn, double yPosIn)
@@ -207,6 +291,8 @@ void mouse_callback (GLFWwindow *window, double xPosIn, double yPosIn)
 
 void process_input (GLFWwindow *window)
 {
+  PROFILE_CPU("process_input");
+
   if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
   {
     glfwSetWindowShouldClose(window, true);
@@ -241,6 +327,30 @@ void process_input (GLFWwindow *window)
   {
     camera.ProcessKeyboard(DOWN, deltaTime);
   }
+
+  if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS && !specular)
+  {
+    specular = true;
+    variantChanged = true;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS && specular)
+  {
+    specular = false;
+    variantChanged = true;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS && shininess != 32.0f)
+  {
+    shininess = 32.0f;
+    variantChanged = true;
+  }
+
+  if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS && shininess != 128.0f)
+  {
+    shininess = 128.0f;
+    variantChanged = true;
+  }
 }
 
 void scroll_callback (GLFWwindow *window, double xOffset, double yOffset)
@@ -0,0 +1,120 @@
+// Micro-benchmark: uniform location lookups through the Shader cache vs
+// the old glGetUniformLocation-per-call path.
+//
+// No OpenGL context is needed: the glad function pointers are replaced by
+// mocks that emulate a program with the uniforms of textureless.*.glsl.
+// The mocked glGetUniformLocation is a plain strcmp search, so the real
+// driver path is slower than what is measured here (it also validates
+// the program and may take a lock).
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <glad/glad.h>
+
+#include "../../include/uniform_cache.h"
+
+const char *UNIFORMS[] = {
+  "model", "view", "projection", "lightPos", "lightColor", "objectColor", "viewPos"
+};
+const int UNIFORM_COUNT = sizeof(UNIFORMS) / sizeof(UNIFORMS[0]);
+const int ITERATIONS = 2000000;
+
+long long driverLookups = 0;
+float sink = 0.0f;
+
+void APIENTRY mock_get_programiv (GLuint program, GLenum pname, GLint *params)
+{
+  *params = pname == GL_ACTIVE_UNIFORMS ? UNIFORM_COUNT : 32;
+}
+
+void APIENTRY mock_get_active_uniform (GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name)
+{
+  *length = (GLsizei)strlen(UNIFORMS[index]);
+  *size = 1;
+  *type = GL_FLOAT_MAT4;
+  memcpy(name, UNIFORMS[index], *length + 1);
+}
+
+GLint APIENTRY mock_get_uniform_location (GLuint program, const GLchar *name)
+{
+  driverLookups++;
+
+  for (int i = 0; i < UNIFORM_COUNT; i++)
+  {
+    if (strcmp(UNIFORMS[i], name) == 0)
+    {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+void APIENTRY mock_uniform_matrix4fv (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value)
+{
+  sink += (float)location;
+}
+
+// The pre-cache Shader API: std::string argument + driver query per call
+void legacy_set (GLuint program, const std::string &name)
+{
+  glUniformMatrix4fv(glGetUniformLocation(program, name.c_str()), 1, GL_FALSE, NULL);
+}
+
+void cached_set (const UniformCache &cache, const UniformName &name)
+{
+  glUniformMatrix4fv(cache.find(name), 1, GL_FALSE, NULL);
+}
+
+template <typename F>
+double measure (const char *label, F body)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < ITERATIONS; i++)
+  {
+    body();
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  double rate = (double)ITERATIONS * 3 / elapsed.count();
+
+  std::cout << label << ": " << rate / 1e6 << " M lookups/s" << std::endl;
+
+  return rate;
+}
+
+int main ()
+{
+  UniformCache cache;
+
+  glad_glGetProgramiv = mock_get_programiv;
+  glad_glGetActiveUniform = mock_get_active_uniform;
+  glad_glGetUniformLocation = mock_get_uniform_location;
+  glad_glUniformMatrix4fv = mock_uniform_matrix4fv;
+
+  cache.build(1);
+  std::cout << "Cached uniforms: " << cache.size() << std::endl;
+
+  // model/view/projection are the per-frame uploads of the lighting examples
+  driverLookups = 0;
+  double legacy = measure("glGetUniformLocation per call", [] () {
+    legacy_set(1, "model");
+    legacy_set(1, "view");
+    legacy_set(1, "projection");
+  });
+  std::cout << "  driver lookups: " << driverLookups << std::endl;
+
+  driverLookups = 0;
+  double cached = measure("UniformCache", [&cache] () {
+    cached_set(cache, "model");
+    cached_set(cache, "view");
+    cached_set(cache, "projection");
+  });
+  std::cout << "  driver lookups: " << driverLookups << std::endl;
+
+  std::cout << "Speed-up: " << cached / legacy << "x" << std::endl;
+
+  return 0;
+}
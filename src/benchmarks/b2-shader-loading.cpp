@@ -0,0 +1,140 @@
+// Benchmark: loading every file in src/shaders/ N times with the old
+// ifstream -> stringstream -> std::string path vs ShaderSource.
+//
+// No OpenGL context is needed, only the file ingestion is measured.
+// Allocations are counted by replacing the global operator new. Bytes
+// copied are NOT measured: they are an estimate from the file sizes of
+// the user-space copies each path makes by design. The old path copies
+// the text into the filebuf, then into the stringstream and again into
+// the std::string (3x); ShaderSource reads it once (files under 64 KiB)
+// or maps it (0x). The output labels them as estimates.
+//
+// Pass a directory as the first argument to load other files, e.g. a
+// directory of big generated shaders to exercise the mmap path.
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../include/shader_source.h"
+
+const int ITERATIONS = 2000;
+
+std::atomic<long long> allocations(0);
+std::atomic<long long> allocatedBytes(0);
+
+void *operator new (size_t size)
+{
+  allocations++;
+  allocatedBytes += size;
+
+  if (void *pointer = malloc(size ? size : 1))
+  {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete (void *pointer) noexcept
+{
+  free(pointer);
+}
+
+void operator delete (void *pointer, size_t) noexcept
+{
+  free(pointer);
+}
+
+// The original Shader constructor code, minus the GL calls
+size_t legacy_load (const std::string &path)
+{
+  std::ifstream file;
+  std::stringstream stream;
+  std::string code;
+
+  file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+  file.open(path);
+  stream << file.rdbuf();
+  file.close();
+  code = stream.str();
+
+  return code.size() + (size_t)code.c_str()[0];
+}
+
+size_t source_load (const std::string &path)
+{
+  ShaderSource source(path.c_str());
+  return source.size() + (source.size() ? (size_t)source.data()[0] : 0);
+}
+
+template <typename F>
+void measure (const char *label, const std::vector<std::string> &files, size_t copiedBytes, F load)
+{
+  size_t checksum = 0;
+  long long startAllocations = allocations;
+  long long startBytes = allocatedBytes;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < ITERATIONS; i++)
+  {
+    for (const std::string &file : files)
+    {
+      checksum += load(file);
+    }
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  double loads = (double)ITERATIONS * files.size();
+
+  std::cout << label << std::endl;
+  std::cout << "  time per load:        " << elapsed.count() / loads * 1e6 << " us" << std::endl;
+  std::cout << "  allocations per load: " << (allocations - startAllocations) / loads << std::endl;
+  std::cout << "  bytes allocated/load: " << (allocatedBytes - startBytes) / loads << std::endl;
+  std::cout << "  bytes copied/load:    " << (double)copiedBytes / files.size() << " (estimate, not measured)" << std::endl;
+  std::cout << "  (checksum " << checksum << ")" << std::endl;
+}
+
+int main (int argc, char **argv)
+{
+  std::string directory = argc > 1 ? argv[1] : "../shaders";
+  std::vector<std::string> files;
+  size_t totalBytes = 0;
+  size_t readBytes = 0;
+
+  for (const auto &entry : std::filesystem::directory_iterator(directory))
+  {
+    if (entry.path().extension() == ".glsl")
+    {
+      files.push_back(entry.path().string());
+      totalBytes += (size_t)entry.file_size();
+
+#ifdef SHADER_SOURCE_MMAP
+      if ((long)entry.file_size() < ShaderSource::MMAP_THRESHOLD)
+#endif
+      {
+        readBytes += (size_t)entry.file_size();
+      }
+    }
+  }
+
+  if (files.empty())
+  {
+    std::cout << "No .glsl files found in " << directory << std::endl;
+    return -1;
+  }
+
+  std::cout << files.size() << " shader files, " << totalBytes << " bytes, "
+            << ITERATIONS << " iterations" << std::endl;
+
+  // Copies per path, from the file sizes (see the top of the file)
+  measure("ifstream + stringstream + std::string", files, 3 * totalBytes, legacy_load);
+  measure("ShaderSource", files, readBytes, source_load);
+
+  return 0;
+}
@@ -0,0 +1,164 @@
+// Benchmark: drawing 100k cubes one by one (a "model" uniform upload and
+// a glDrawElements per cube) vs CubeInstances (one instance buffer upload
+// and one glDrawElementsInstanced).
+//
+// Opens a window with vsync off. Both paths draw the same rotating grid;
+// the model matrices are computed outside of the timed section, which
+// only covers the CPU submission of the GL calls of a frame. Pass the
+// number of cubes as the first argument to try other sizes.
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../../include/cube.h"
+#include "../../include/cube_instances.h"
+#include "../../include/frame_uniforms.h"
+#include "../../include/shader_s.h"
+
+const int SCR_HEIGHT = 720;
+const int SCR_WIDTH = 1280;
+const int WARMUP_FRAMES = 10;
+const int FRAMES = 120;
+
+// Lays the cubes out on a grid roughly twice as wide as it is tall
+std::vector<glm::vec3> grid_positions (size_t count)
+{
+  std::vector<glm::vec3> positions;
+  int side = 1;
+
+  while ((size_t)side * side * (side / 2 + 1) < count)
+  {
+    side++;
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    int x = (int)(i % side);
+    int z = (int)(i / side % side);
+    int y = (int)(i / ((size_t)side * side));
+
+    positions.push_back(glm::vec3(x - side / 2, y - side / 4, -z) * 2.0f);
+  }
+
+  return positions;
+}
+
+void update_models (const std::vector<glm::vec3> &positions, std::vector<glm::mat4> &models, float time)
+{
+  for (size_t i = 0; i < positions.size(); i++)
+  {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), positions[i]);
+    models[i] = glm::rotate(model, time + 0.01f * i, glm::vec3(1.0f, 0.3f, 0.5f));
+  }
+}
+
+template <typename F>
+void measure (const char *label, GLFWwindow *window, const std::vector<glm::vec3> &positions, F submit)
+{
+  std::vector<glm::mat4> models(positions.size());
+  double total = 0.0, best = 1e9;
+  unsigned int draws = 0;
+
+  for (int frame = 0; frame < WARMUP_FRAMES + FRAMES; frame++)
+  {
+    update_models(positions, models, frame * 0.02f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    auto start = std::chrono::steady_clock::now();
+    draws = submit(models);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+
+    if (frame >= WARMUP_FRAMES)
+    {
+      total += elapsed.count();
+      best = elapsed.count() < best ? elapsed.count() : best;
+    }
+  }
+
+  std::cout << label << std::endl;
+  std::cout << "  draw calls per frame:      " << draws << std::endl;
+  std::cout << "  CPU submission per frame:  " << total / FRAMES * 1000.0 << " ms (best " << best * 1000.0 << " ms)" << std::endl;
+}
+
+int main (int argc, char **argv)
+{
+  size_t count = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+  GLFWwindow *window;
+
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Instanced cubes", NULL, NULL);
+  if (window == NULL)
+  {
+    std::cout << "Error al crear la ventana" << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSwapInterval(0);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+  {
+    std::cout << "Error al cargar las funciones de OpenGL" << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+  glEnable(GL_DEPTH_TEST);
+  glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+
+  std::vector<glm::vec3> positions = grid_positions(count);
+  std::cout << count << " cubes, " << FRAMES << " frames" << std::endl;
+
+  FrameUniforms frame;
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 30.0f, 40.0f), glm::vec3(0.0f, 0.0f, -40.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 500.0f);
+  frame.update(view, projection, glm::vec3(0.0f, 30.0f, 40.0f), 0.0f);
+
+  std::string defines = FrameUniforms::DEFINE;
+  Shader singleShader("../shaders/cube-color.vs.glsl", "../shaders/cube-color.fs.glsl", defines);
+  Shader instancedShader("../shaders/cube-color.vs.glsl", "../shaders/cube-color.fs.glsl", defines + "#define INSTANCED 1\n");
+  singleShader.bindUniformBlock(FrameUniforms::BLOCK, FrameUniforms::BINDING);
+  instancedShader.bindUniformBlock(FrameUniforms::BLOCK, FrameUniforms::BINDING);
+
+  Cube cube;
+  CubeInstances instances(count);
+
+  measure("One draw per cube", window, positions, [&] (const std::vector<glm::mat4> &models) {
+    singleShader.use();
+    for (const glm::mat4 &model : models)
+    {
+      singleShader.setMat4("model", model);
+      cube.draw();
+    }
+    return (unsigned int)models.size();
+  });
+
+  measure("CubeInstances", window, positions, [&] (const std::vector<glm::mat4> &models) {
+    instancedShader.use();
+    instances.update(models);
+    instances.draw();
+    return 1u;
+  });
+
+  instances.clear();
+  cube.clear();
+  singleShader.clear();
+  instancedShader.clear();
+  frame.clear();
+  glfwTerminate();
+
+  return 0;
+}
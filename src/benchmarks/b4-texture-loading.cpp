@@ -0,0 +1,173 @@
+// Benchmark: loading every .jpg/.png of a directory as textures, one
+// after the other on the main thread (stbi_load + glTexImage2D +
+// glGenerateMipmap per file) vs TextureLoader (decodes on a thread pool,
+// uploads on the main thread).
+//
+// Usage: b4-texture-loading [DIRECTORY] [--repeat=N] [--threads=N]
+//                           [--budget=MB] [--headless ...]
+//
+// DIRECTORY defaults to ../../textures. Each file is loaded N times
+// (default 16) to get a directory of "many images" out of a small one.
+// Both paths end with glFinish(), so the uploads are counted too.
+//
+// Then the same images are streamed in mid-session, one update per
+// frame, with glTexImage2D from client memory vs a TextureStreamer with
+// a budget of MB megabytes per frame (default 4), and the worst CPU time
+// spent uploading in one frame is compared.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../../include/texture_loader.h"
+#include "texture_bench.h"
+
+double load_threaded (const std::vector<std::string> &paths, std::vector<unsigned int> &textures, unsigned int threads, TextureLoader::Stats &stats)
+{
+  auto start = std::chrono::steady_clock::now();
+  TextureLoader loader(threads);
+
+  for (const std::string &path : paths)
+  {
+    textures.push_back(loader.load(path, true));
+  }
+  loader.finish();
+  glFinish();
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  stats = loader.getStats();
+  return elapsed.count();
+}
+
+struct Streaming
+{
+  double worstMs = 0.0;
+  unsigned int frames = 0;
+};
+
+// Loads while rendering empty frames, timing the uploads of each frame
+Streaming stream (GLFWwindow *window, const std::vector<std::string> &paths, std::vector<unsigned int> &textures, unsigned int threads, TextureStreamer *streamer)
+{
+  TextureLoader loader(threads);
+  Streaming result;
+  unsigned int pending = 1;
+
+  loader.setStreamer(streamer);
+  for (const std::string &path : paths)
+  {
+    textures.push_back(loader.load(path, true));
+  }
+
+  while (pending > 0)
+  {
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    auto start = std::chrono::steady_clock::now();
+    pending = loader.update();
+    if (streamer)
+    {
+      pending += streamer->update();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+
+    result.worstMs = elapsed.count() > result.worstMs ? elapsed.count() : result.worstMs;
+    result.frames++;
+  }
+  glFinish();
+
+  return result;
+}
+
+int main (int argc, char **argv)
+{
+  std::string directory = "../../textures";
+  unsigned int repeat = 16, threads = std::thread::hardware_concurrency(), budget = 4;
+  GLFWwindow *window;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--repeat=", 9) == 0)
+    {
+      repeat = (unsigned int)atoi(argv[i] + 9);
+    }
+    else if (strncmp(argv[i], "--threads=", 10) == 0)
+    {
+      threads = (unsigned int)atoi(argv[i] + 10);
+    }
+    else if (strncmp(argv[i], "--budget=", 9) == 0)
+    {
+      budget = (unsigned int)atoi(argv[i] + 9);
+    }
+    else if (strncmp(argv[i], "--", 2) != 0)
+    {
+      directory = argv[i];
+    }
+  }
+
+  window = create_context(argc, argv, "Texture loading");
+  if (window == NULL)
+  {
+    return -1;
+  }
+
+  std::vector<std::string> files = list_images(directory), paths;
+  for (unsigned int i = 0; i < repeat; i++)
+  {
+    paths.insert(paths.end(), files.begin(), files.end());
+  }
+
+  if (paths.empty())
+  {
+    std::cout << "No .jpg/.png files in " << directory << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+
+  std::vector<unsigned int> textures;
+  TextureLoader::Stats stats;
+
+  // Warm the file cache and the driver up, so neither run pays for it
+  load_stb(files, textures);
+  release(textures);
+
+  double serial = load_stb(paths, textures);
+  release(textures);
+
+  double threaded = load_threaded(paths, textures, threads, stats);
+  release(textures);
+
+  Streaming direct = stream(window, paths, textures, threads, NULL);
+  release(textures);
+
+  TextureStreamer streamer((GLADloadproc)glfwGetProcAddress, 16 << 20, (size_t)budget << 20);
+  Streaming streamed = stream(window, paths, textures, threads, &streamer);
+  release(textures);
+
+  std::cout << paths.size() << " images (" << files.size() << " files x " << repeat << ") from " << directory << std::endl;
+  std::cout << "Serial:         " << serial << " ms" << std::endl;
+  std::cout << "TextureLoader:  " << threaded << " ms, " << threads << " threads ("
+            << serial / threaded << "x)" << std::endl;
+  std::cout << "  decode, sum:  " << stats.decodeMs << " ms" << std::endl;
+  std::cout << "  decode, max:  " << stats.maxDecodeMs << " ms" << std::endl;
+  std::cout << "  upload:       " << stats.uploadMs << " ms on the GL thread" << std::endl;
+  std::cout << "  failed:       " << stats.failed << std::endl;
+  std::cout << "Streaming, worst upload time in one frame:" << std::endl;
+  std::cout << "  glTexImage2D:     " << direct.worstMs << " ms, " << direct.frames << " frames" << std::endl;
+  std::cout << "  TextureStreamer:  " << streamed.worstMs << " ms, " << streamed.frames << " frames, "
+            << budget << " MB/frame, " << (streamer.isPersistent() ? "persistent" : "unsynchronized") << " mapping, "
+            << streamer.getStats().fenceSkips << " frames skipped on a fence" << std::endl;
+
+  streamer.clear();
+
+  glfwTerminate();
+
+  return 0;
+}
@@ -0,0 +1,190 @@
+// Benchmark: time to get the textures of a directory onto the GPU at
+// startup, decoding them with stb_image and building the mipmaps with
+// glGenerateMipmap (what the examples did) vs mapping files cooked by
+// TextureFile::cook() and uploading their levels as they are.
+//
+// Usage: b5-texture-cold-start [DIRECTORY] [--runs=N] [--headless ...]
+//
+// DIRECTORY defaults to ../../textures; its .jpg/.png files are cooked
+// (flipped, with mipmaps) into a temporary directory first, untimed.
+// Each path is timed N times (default 5) and the median is printed, from
+// the file to glFinish().
+//
+// "Cold" runs drop the files from the page cache first (posix_fadvise
+// DONTNEED, no root needed), so the disk reads are counted as on a fresh
+// boot; "warm" runs read them from memory. Cooked files are bigger on
+// disk than the compressed sources, which is what the cold runs weigh
+// against the decode.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "../../include/texture_file.h"
+#include "texture_bench.h"
+
+// Asks the kernel to forget the cached pages of a file
+bool evict (const std::string &path)
+{
+#if defined(__unix__)
+  int fd = open(path.c_str(), O_RDONLY);
+
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  // Dirty pages (the cooked files were just written) are not dropped
+  fdatasync(fd);
+  bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  close(fd);
+  return evicted;
+#else
+  (void)path;
+  return false;
+#endif
+}
+
+double load_cooked (const std::vector<std::string> &paths, std::vector<unsigned int> &textures)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  for (const std::string &path : paths)
+  {
+    TextureFile file(path);
+    unsigned int texture;
+
+    glGenTextures(1, &texture);
+    if (file.isOpen())
+    {
+      file.upload(texture);
+    }
+
+    textures.push_back(texture);
+  }
+  glFinish();
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// Median of runs of one path, cold or warm
+double measure (double (*load) (const std::vector<std::string> &, std::vector<unsigned int> &),
+                const std::vector<std::string> &paths, int runs, bool cold)
+{
+  std::vector<unsigned int> textures;
+  std::vector<double> times;
+
+  for (int i = 0; i < runs; i++)
+  {
+    if (cold)
+    {
+      for (const std::string &path : paths)
+      {
+        evict(path);
+      }
+    }
+
+    times.push_back(load(paths, textures));
+    release(textures);
+  }
+
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+uintmax_t total_size (const std::vector<std::string> &paths)
+{
+  uintmax_t size = 0;
+
+  for (const std::string &path : paths)
+  {
+    size += std::filesystem::file_size(path);
+  }
+
+  return size;
+}
+
+int main (int argc, char **argv)
+{
+  std::string directory = "../../textures";
+  int runs = 5;
+  GLFWwindow *window;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--runs=", 7) == 0)
+    {
+      runs = std::max(1, atoi(argv[i] + 7));
+    }
+    else if (strncmp(argv[i], "--", 2) != 0)
+    {
+      directory = argv[i];
+    }
+  }
+
+  window = create_context(argc, argv, "Texture cold start");
+  if (window == NULL)
+  {
+    return -1;
+  }
+
+  std::filesystem::path cookedDirectory = std::filesystem::temp_directory_path() / "learngl-cooked";
+  std::vector<std::string> sources, cooked;
+
+  std::filesystem::create_directories(cookedDirectory);
+  for (const std::string &source : list_images(directory))
+  {
+    std::filesystem::path output = cookedDirectory / std::filesystem::path(source).filename().replace_extension(".lgtx");
+
+    if (TextureFile::cook(source, output.string(), true))
+    {
+      sources.push_back(source);
+      cooked.push_back(output.string());
+    }
+  }
+
+  if (sources.empty())
+  {
+    std::cout << "No .jpg/.png files in " << directory << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+
+  // Let the driver set itself up before anything is timed
+  std::vector<unsigned int> textures;
+  load_stb(sources, textures);
+  release(textures);
+
+  bool canEvict = evict(sources[0]);
+  double stbCold = measure(load_stb, sources, runs, true);
+  double cookedCold = measure(load_cooked, cooked, runs, true);
+  double stbWarm = measure(load_stb, sources, runs, false);
+  double cookedWarm = measure(load_cooked, cooked, runs, false);
+
+  std::cout << sources.size() << " textures from " << directory << ", median of " << runs << " runs" << std::endl;
+  std::cout << "              on disk      cold         warm" << std::endl;
+  std::cout << "stb_image:    " << total_size(sources) / 1024 << " KiB      " << stbCold << " ms     " << stbWarm << " ms" << std::endl;
+  std::cout << "cooked:       " << total_size(cooked) / 1024 << " KiB      " << cookedCold << " ms     " << cookedWarm << " ms" << std::endl;
+  std::cout << "speedup:                   " << stbCold / cookedCold << "x        " << stbWarm / cookedWarm << "x" << std::endl;
+  if (!canEvict)
+  {
+    std::cout << "(the page cache could not be dropped: cold runs are warm)" << std::endl;
+  }
+
+  std::filesystem::remove_all(cookedDirectory);
+  glfwTerminate();
+
+  return 0;
+}
@@ -0,0 +1,114 @@
+// Benchmark: quality and speed of BlockCompression on the .jpg/.png
+// files of a directory, for BC1, BC3 and BC7.
+//
+// Usage: b6-block-compression [DIRECTORY] [--repeat=N] [--threads=N]
+//
+// DIRECTORY defaults to ../../textures. Each image is compressed N times
+// (default 8) on one thread and on a ThreadPool of the given size (one
+// per hardware thread by default); throughput is in megapixels per
+// second of the fastest run. Quality is the PSNR of the decompressed
+// image against the source, for the color and, in images that have one,
+// the alpha channel. No OpenGL context is needed.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../include/block_compression.h"
+#include "../../include/stb_image.h"
+#include "../../include/thread_pool.h"
+
+// Fastest of repeat runs, in megapixels per second
+double throughput (const unsigned char *pixels, int width, int height, int channels,
+                   BlockCompression::Format format, ThreadPool *pool, unsigned int repeat)
+{
+  double best = 1e30;
+
+  for (unsigned int i = 0; i < repeat; i++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    BlockCompression::compress(pixels, width, height, channels, format, pool);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    best = elapsed.count() < best ? elapsed.count() : best;
+  }
+
+  return (double)width * height / 1e6 / best;
+}
+
+int main (int argc, char **argv)
+{
+  static const BlockCompression::Format FORMATS[] = {BlockCompression::BC1, BlockCompression::BC3, BlockCompression::BC7};
+  static const char *NAMES[] = {"BC1", "BC3", "BC7"};
+  std::string directory = "../../textures";
+  unsigned int repeat = 8, threads = std::thread::hardware_concurrency();
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--repeat=", 9) == 0)
+    {
+      repeat = (unsigned int)atoi(argv[i] + 9);
+    }
+    else if (strncmp(argv[i], "--threads=", 10) == 0)
+    {
+      threads = (unsigned int)atoi(argv[i] + 10);
+    }
+    else if (strncmp(argv[i], "--", 2) != 0)
+    {
+      directory = argv[i];
+    }
+  }
+
+  ThreadPool pool(threads);
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "image                  format  RGB dB  alpha dB  1 thread MP/s  " << pool.size() << " threads MP/s" << std::endl;
+
+  for (const auto &entry : std::filesystem::directory_iterator(directory))
+  {
+    std::string extension = entry.path().extension().string();
+    int width, height, channels;
+
+    if (extension != ".jpg" && extension != ".jpeg" && extension != ".png")
+    {
+      continue;
+    }
+
+    unsigned char *pixels = stbi_load(entry.path().string().c_str(), &width, &height, &channels, 0);
+    if (!pixels)
+    {
+      std::cout << "Could not load " << entry.path().string() << std::endl;
+      continue;
+    }
+
+    for (int f = 0; f < 3; f++)
+    {
+      std::vector<unsigned char> blocks = BlockCompression::compress(pixels, width, height, channels, FORMATS[f], &pool);
+      std::vector<unsigned char> decoded = BlockCompression::decompress(blocks.data(), width, height, FORMATS[f]);
+      double color = BlockCompression::psnr(pixels, decoded.data(), width, height, channels, 0, 3);
+      double single = throughput(pixels, width, height, channels, FORMATS[f], NULL, repeat);
+      double parallel = throughput(pixels, width, height, channels, FORMATS[f], &pool, repeat);
+
+      std::cout << std::left << std::setw(23) << entry.path().filename().string() << std::setw(8) << NAMES[f]
+                << std::right << std::setw(6) << color << "  ";
+      if (channels == 4)
+      {
+        std::cout << std::setw(8) << BlockCompression::psnr(pixels, decoded.data(), width, height, channels, 3, 1);
+      }
+      else
+      {
+        std::cout << std::setw(8) << "-";
+      }
+      std::cout << std::setw(15) << single << std::setw(16) << parallel << std::endl;
+    }
+
+    stbi_image_free(pixels);
+  }
+
+  return 0;
+}
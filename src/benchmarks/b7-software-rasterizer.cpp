@@ -0,0 +1,196 @@
+// Benchmark: SoftwareRasterizer drawing a grid of lit cubes (the vertex
+// array and Phong lighting of 02b-basic-lighting) at several thread
+// counts. No GPU or OpenGL context is needed.
+//
+// Usage: b7-software-rasterizer [--cubes=N] [--size=WIDTHxHEIGHT]
+//                               [--frames=N] [--threads=N,N,...]
+//                               [--output=FILE.ppm]
+//
+// Defaults: 400 cubes, 800x600, 20 frames, threads 1, 2, 4... up to the
+// number of hardware threads. Mpixels/s counts the pixels of the frame,
+// fragments/s the ones that passed the depth test and were shaded, and
+// triangles/s the ones submitted. --output saves the last frame.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../../include/camera.h"
+#include "../../include/software_rasterizer.h"
+
+const float VERTICES[] = {
+  -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+   0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+   0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+   0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+  -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+  -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
+
+  -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+   0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+   0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+   0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+  -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+  -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+
+  -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+  -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+  -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+  -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,
+  -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+  -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,
+
+   0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+   0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+   0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+   0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,
+   0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+   0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,
+
+  -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+   0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+   0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+   0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+  -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,
+  -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,
+
+  -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
+   0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
+   0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+   0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+  -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,
+  -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f
+};
+
+struct Result
+{
+  double ms;
+  SoftwareRasterizer::Stats stats;
+};
+
+// Renders frames of a square grid of spinning cubes, seen from above
+Result render (SoftwareRasterizer &rasterizer, int cubes, int frames)
+{
+  Camera camera(glm::vec3(0.0f, 6.0f, 14.0f));
+  SoftwareRasterizer::Phong phong;
+  int side = 1;
+  Result result = {0.0, SoftwareRasterizer::Stats()};
+
+  while (side * side < cubes)
+  {
+    side++;
+  }
+
+  camera.ProcessMouseMovement(0.0f, -250.0f);
+  camera.SetAspect((float)rasterizer.getWidth() / (float)rasterizer.getHeight());
+  phong.view = camera.GetViewMatrix();
+  phong.projection = camera.GetProjectionMatrix();
+  phong.viewPos = camera.Position;
+  phong.lightPos = glm::vec3(1.2f, 4.0f, 2.0f);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < frames; frame++)
+  {
+    float time = frame * 0.05f;
+
+    rasterizer.clear(glm::vec3(0.1f, 0.1f, 0.1f));
+    for (int i = 0; i < cubes; i++)
+    {
+      glm::vec3 position((i % side - side / 2) * 1.5f, 0.0f, (i / side - side / 2) * 1.5f);
+
+      phong.model = glm::translate(glm::mat4(1.0f), position * (12.0f / (side * 1.5f)));
+      phong.model = glm::rotate(phong.model, time + 0.1f * i, glm::vec3(0.5f, 1.0f, 0.0f));
+      phong.model = glm::scale(phong.model, glm::vec3(12.0f / (side * 1.5f)));
+      rasterizer.draw(VERTICES, 36, phong);
+    }
+    rasterizer.finish();
+    result.stats.triangles += rasterizer.getStats().triangles;
+    result.stats.fragments += rasterizer.getStats().fragments;
+  }
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  result.ms = elapsed.count();
+  return result;
+}
+
+int main (int argc, char **argv)
+{
+  int cubes = 400, width = 800, height = 600, frames = 20;
+  std::vector<unsigned int> threads;
+  std::string output;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--cubes=", 8) == 0)
+    {
+      cubes = atoi(argv[i] + 8);
+    }
+    else if (strncmp(argv[i], "--size=", 7) == 0)
+    {
+      sscanf(argv[i] + 7, "%dx%d", &width, &height);
+    }
+    else if (strncmp(argv[i], "--frames=", 9) == 0)
+    {
+      frames = atoi(argv[i] + 9);
+    }
+    else if (strncmp(argv[i], "--threads=", 10) == 0)
+    {
+      for (const char *list = argv[i] + 10; *list; list += strcspn(list, ","), list += *list == ',')
+      {
+        threads.push_back((unsigned int)atoi(list));
+      }
+    }
+    else if (strncmp(argv[i], "--output=", 9) == 0)
+    {
+      output = argv[i] + 9;
+    }
+  }
+
+  if (threads.empty())
+  {
+    unsigned int hardware = std::thread::hardware_concurrency();
+
+    for (unsigned int count = 1; count < hardware; count *= 2)
+    {
+      threads.push_back(count);
+    }
+    threads.push_back(hardware > 0 ? hardware : 1);
+  }
+
+  std::cout << cubes << " cubes (" << cubes * 12 << " triangles), " << width << "x" << height << ", "
+            << frames << " frames, " << SOFTWARE_RASTERIZER_LANES << " pixels per edge test" << std::endl;
+  std::cout << "threads  ms/frame  Mpixels/s  Mfragments/s  Mtriangles/s  speedup" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+
+  double baseline = 0.0;
+  for (unsigned int count : threads)
+  {
+    SoftwareRasterizer rasterizer(width, height, count);
+
+    render(rasterizer, cubes, 1);
+    Result result = render(rasterizer, cubes, frames);
+    double seconds = result.ms / 1000.0;
+
+    baseline = baseline > 0.0 ? baseline : result.ms;
+    std::cout << std::setw(7) << rasterizer.threads() << std::setw(10) << result.ms / frames
+              << std::setw(11) << (double)width * height * frames / seconds / 1e6
+              << std::setw(14) << result.stats.fragments / seconds / 1e6
+              << std::setw(14) << result.stats.triangles / seconds / 1e6
+              << std::setw(8) << baseline / result.ms << "x" << std::endl;
+
+    if (!output.empty() && count == threads.back())
+    {
+      rasterizer.writePPM(output);
+    }
+  }
+
+  return 0;
+}
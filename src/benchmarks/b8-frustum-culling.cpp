@@ -0,0 +1,208 @@
+// Benchmark: culling a million bounding volumes against the frustum of a
+// Camera, one Frustum::containsBox() call per object vs FrustumCuller
+// (8 objects per batch) at several thread counts. No GPU or OpenGL
+// context is needed.
+//
+// Usage: b8-frustum-culling [--count=N] [--repeat=N] [--threads=N,N,...]
+//
+// Defaults: 1000000 boxes and as many spheres scattered in a 200-unit
+// cube around the camera, 50 repetitions, threads 1, 2, 4... up to the
+// number of hardware threads. The camera turns between repetitions, so
+// the frustum is never the same twice. Each row prints the time per
+// object and checks that the visible set is the same as the scalar one;
+// the exit status is 1 when it is not (see the tests in CMakeLists.txt).
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../../include/camera.h"
+#include "../../include/frustum_culler.h"
+
+struct Result
+{
+  double ms = 0.0;
+  size_t visible = 0;
+  size_t mismatches = 0;
+};
+
+// Runs cull once per repetition, turning the camera in between. The
+// results are compared with expected, or saved into it when it is empty
+template <typename Cull>
+Result measure (int repeat, std::vector<std::vector<uint8_t>> &expected, Cull cull)
+{
+  bool record = expected.empty();
+  Camera camera;
+  std::vector<uint8_t> visible;
+  Result result;
+
+  for (int i = 0; i < repeat; i++)
+  {
+    camera.ProcessMouseMovement(360.0f / repeat / camera.MouseSensitivity, 0.0f);
+    Frustum frustum = camera.GetFrustum();
+
+    auto start = std::chrono::steady_clock::now();
+    result.visible += cull(frustum, visible);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    result.ms += elapsed.count();
+
+    if (record)
+    {
+      expected.push_back(visible);
+    }
+    else
+    {
+      for (size_t j = 0; j < visible.size(); j++)
+      {
+        result.mismatches += visible[j] != expected[i][j];
+      }
+    }
+  }
+
+  return result;
+}
+
+void print (const char *name, const Result &result, size_t objects, int repeat, double baseline)
+{
+  std::cout << std::left << std::setw(24) << name << std::right
+            << std::setw(9) << result.ms * 1e6 / ((double)objects * repeat)
+            << std::setw(11) << result.visible / repeat
+            << std::setw(9) << baseline / result.ms << "x"
+            << (result.mismatches ? "  MISMATCHES: " + std::to_string(result.mismatches) : "") << std::endl;
+}
+
+int main (int argc, char **argv)
+{
+  size_t count = 1000000;
+  int repeat = 50;
+  std::vector<unsigned int> threads;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--count=", 8) == 0)
+    {
+      count = (size_t)atol(argv[i] + 8);
+    }
+    else if (strncmp(argv[i], "--repeat=", 9) == 0)
+    {
+      repeat = std::max(1, atoi(argv[i] + 9));
+    }
+    else if (strncmp(argv[i], "--threads=", 10) == 0)
+    {
+      for (const char *list = argv[i] + 10; *list; list += strcspn(list, ","), list += *list == ',')
+      {
+        threads.push_back((unsigned int)atoi(list));
+      }
+    }
+  }
+
+  if (threads.empty())
+  {
+    unsigned int hardware = std::thread::hardware_concurrency();
+
+    for (unsigned int n = 1; n < hardware; n *= 2)
+    {
+      threads.push_back(n);
+    }
+    threads.push_back(hardware > 0 ? hardware : 1);
+  }
+
+  std::mt19937 random(1234);
+  std::uniform_real_distribution<float> position(-100.0f, 100.0f), size(0.25f, 2.0f);
+  FrustumCuller::Boxes boxes;
+  FrustumCuller::Spheres spheres;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    glm::vec3 center(position(random), position(random), position(random));
+    glm::vec3 extents(size(random), size(random), size(random));
+
+    boxes.add(center - extents, center + extents);
+    spheres.add(center, size(random));
+  }
+
+  // The scalar decisions of every repetition, to check the batched ones
+  std::vector<std::vector<uint8_t>> boxesExpected, spheresExpected;
+  Result boxesScalar = measure(repeat, boxesExpected, [&] (const Frustum &frustum, std::vector<uint8_t> &visible)
+  {
+    size_t inside = 0;
+
+    visible.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      glm::vec3 center(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+      glm::vec3 extents(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+
+      visible[i] = frustum.containsBox(center, extents) ? 1 : 0;
+      inside += visible[i];
+    }
+
+    return inside;
+  });
+  Result spheresScalar = measure(repeat, spheresExpected, [&] (const Frustum &frustum, std::vector<uint8_t> &visible)
+  {
+    size_t inside = 0;
+
+    visible.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      visible[i] = frustum.containsSphere(glm::vec3(spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i]), spheres.radius[i]) ? 1 : 0;
+      inside += visible[i];
+    }
+
+    return inside;
+  });
+
+#if defined(FRUSTUM_CULLER_AVX)
+  const char *instructions = "AVX";
+#elif defined(FRUSTUM_CULLER_SSE2)
+  const char *instructions = "SSE2";
+#else
+  const char *instructions = "scalar";
+#endif
+
+  std::cout << count << " boxes and " << count << " spheres, " << repeat << " frustums, "
+            << instructions << " batches of " << FrustumCuller::BATCH << std::endl;
+  std::cout << "                     ns/object   visible  speedup" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+
+  size_t mismatches = 0;
+
+  print("boxes, containsBox", boxesScalar, count, repeat, boxesScalar.ms);
+  for (unsigned int n : threads)
+  {
+    ThreadPool pool(n);
+    std::string name = "boxes, " + std::to_string(n) + " thread" + (n > 1 ? "s" : "");
+    Result result = measure(repeat, boxesExpected, [&] (const Frustum &frustum, std::vector<uint8_t> &visible)
+    {
+      return FrustumCuller::cull(frustum, boxes, visible, &pool);
+    });
+
+    print(name.c_str(), result, count, repeat, boxesScalar.ms);
+    mismatches += result.mismatches;
+  }
+
+  print("spheres, containsSphere", spheresScalar, count, repeat, spheresScalar.ms);
+  for (unsigned int n : threads)
+  {
+    ThreadPool pool(n);
+    std::string name = "spheres, " + std::to_string(n) + " thread" + (n > 1 ? "s" : "");
+    Result result = measure(repeat, spheresExpected, [&] (const Frustum &frustum, std::vector<uint8_t> &visible)
+    {
+      return FrustumCuller::cull(frustum, spheres, visible, &pool);
+    });
+
+    print(name.c_str(), result, count, repeat, spheresScalar.ms);
+    mismatches += result.mismatches;
+  }
+
+  return mismatches ? 1 : 0;
+}
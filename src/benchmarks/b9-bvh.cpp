@@ -0,0 +1,274 @@
+// Benchmark: Bvh over the bounds of rotating cubes (as in
+// 08-coordinate-systems), at several object counts. No GPU or OpenGL
+// context is needed.
+//
+// Usage: b9-bvh [--counts=N,N,...] [--threads=N] [--queries=N]
+//
+// Defaults: 10000, 100000 and 1000000 cubes, one thread per hardware
+// thread, 1000 queries of each kind. The cubes are scattered with the
+// same density at every count, and each turns on its own axis; refit
+// moves them to the next frame.
+//
+// For each count it prints the time to build the tree on one thread and
+// on the pool, to refit it, and what refit did to its SAH cost; then the
+// time of one frustum query (vs FrustumCuller testing every object), one
+// ray and one box query. The objects each frustum and box query finds
+// are checked, as sorted sets, against testing every object, and so is
+// the nearest hit of the first 20 rays; the exit status is 1 when any
+// differ.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../../include/bvh.h"
+#include "../../include/camera.h"
+#include "../../include/frustum_culler.h"
+
+struct Cubes
+{
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> axes;
+  std::vector<Bvh::Bounds> bounds;
+};
+
+// Bounds of every cube turned as at time
+void move (Cubes &cubes, float time)
+{
+  for (size_t i = 0; i < cubes.positions.size(); i++)
+  {
+    glm::mat4 model = glm::rotate(glm::mat4(1.0f), time + 0.1f * i, cubes.axes[i]);
+    glm::vec3 extents;
+
+    // Half-size of the box around a unit cube with that rotation
+    for (int j = 0; j < 3; j++)
+    {
+      extents[j] = 0.5f * (std::fabs(model[0][j]) + std::fabs(model[1][j]) + std::fabs(model[2][j]));
+    }
+
+    cubes.bounds[i].min = cubes.positions[i] - extents;
+    cubes.bounds[i].max = cubes.positions[i] + extents;
+  }
+}
+
+// Whether a query found exactly the objects expected, in any order
+bool same (std::vector<uint32_t> &found, const std::vector<uint32_t> &expected)
+{
+  std::sort(found.begin(), found.end());
+  return found == expected;
+}
+
+// Distance at which a ray enters a box, or infinity
+float slab (const Bvh::Bounds &bounds, const glm::vec3 &origin, const glm::vec3 &direction)
+{
+  float entry = 0.0f, exit = std::numeric_limits<float>::max();
+
+  for (int j = 0; j < 3; j++)
+  {
+    float t1 = (bounds.min[j] - origin[j]) / direction[j], t2 = (bounds.max[j] - origin[j]) / direction[j];
+
+    entry = std::max(entry, std::min(t1, t2));
+    exit = std::min(exit, std::max(t1, t2));
+  }
+
+  return entry <= exit ? entry : std::numeric_limits<float>::max();
+}
+
+template <typename F>
+double time_ms (F f)
+{
+  auto start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+int main (int argc, char **argv)
+{
+  std::vector<size_t> counts;
+  unsigned int threads = std::thread::hardware_concurrency();
+  int queries = 1000;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--counts=", 9) == 0)
+    {
+      for (const char *list = argv[i] + 9; *list; list += strcspn(list, ","), list += *list == ',')
+      {
+        counts.push_back((size_t)atol(list));
+      }
+    }
+    else if (strncmp(argv[i], "--threads=", 10) == 0)
+    {
+      threads = (unsigned int)atoi(argv[i] + 10);
+    }
+    else if (strncmp(argv[i], "--queries=", 10) == 0)
+    {
+      queries = std::max(1, atoi(argv[i] + 10));
+    }
+  }
+
+  if (counts.empty())
+  {
+    counts = {10000, 100000, 1000000};
+  }
+
+  ThreadPool pool(threads);
+  size_t failures = 0;
+
+  std::cout << "objects   build ms  (" << pool.size() << " threads)  refit ms   cost build/refit"
+            << "   frustum us (linear)   ray us   box us" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+
+  for (size_t count : counts)
+  {
+    std::mt19937 random(1234);
+    float side = 3.0f * std::cbrt((float)count);
+    std::uniform_real_distribution<float> position(-side / 2.0f, side / 2.0f), unit(-1.0f, 1.0f);
+    Cubes cubes;
+
+    for (size_t i = 0; i < count; i++)
+    {
+      glm::vec3 axis(unit(random), unit(random), unit(random));
+
+      cubes.positions.push_back(glm::vec3(position(random), position(random), position(random)));
+      cubes.axes.push_back(glm::length(axis) > 0.01f ? glm::normalize(axis) : glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    cubes.bounds.resize(count);
+    move(cubes, 0.0f);
+
+    Bvh bvh;
+    double serial = time_ms([&] () { bvh.build(cubes.bounds); });
+    double parallel = time_ms([&] () { bvh.build(cubes.bounds, &pool); });
+    float built = bvh.cost();
+
+    move(cubes, 1.0f);
+    double refit = time_ms([&] () { bvh.refit(cubes.bounds); });
+    float refitted = bvh.cost();
+
+    // Frustums from the middle of the cubes, turning
+    Camera camera;
+    FrustumCuller::Boxes boxes;
+    std::vector<uint8_t> visible;
+    std::vector<uint32_t> ids, expectedIds;
+    size_t mismatches = 0, found = 0, expected = 0;
+    double frustumMs = 0.0, linearMs = 0.0;
+
+    camera.SetProjection(ASPECT, 0.1f, side / 4.0f);
+
+    for (const Bvh::Bounds &bound : cubes.bounds)
+    {
+      boxes.add(bound.min, bound.max);
+    }
+
+    for (int q = 0; q < queries; q++)
+    {
+      camera.ProcessMouseMovement(3600.0f / queries, 0.0f);
+      Frustum frustum = camera.GetFrustum();
+
+      frustumMs += time_ms([&] () { bvh.query(frustum, [&found] (uint32_t) { found++; }); });
+      linearMs += time_ms([&] () { expected += FrustumCuller::cull(frustum, boxes, visible); });
+
+      ids.clear();
+      bvh.query(frustum, [&ids] (uint32_t i) { ids.push_back(i); });
+      expectedIds.clear();
+      for (uint32_t i = 0; i < (uint32_t)count; i++)
+      {
+        if (visible[i])
+        {
+          expectedIds.push_back(i);
+        }
+      }
+      mismatches += !same(ids, expectedIds);
+    }
+
+    // Rays from random points in random directions, checked on a few
+    std::vector<glm::vec3> origins, directions;
+    for (int q = 0; q < queries; q++)
+    {
+      glm::vec3 direction(unit(random), unit(random), unit(random));
+
+      origins.push_back(glm::vec3(position(random), position(random), position(random)));
+      directions.push_back(glm::length(direction) > 0.01f ? glm::normalize(direction) : glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+
+    std::vector<int> hits(queries);
+    double rayMs = time_ms([&] ()
+    {
+      for (int q = 0; q < queries; q++)
+      {
+        float distance = side;
+        hits[q] = bvh.raycast(origins[q], directions[q], distance);
+      }
+    });
+
+    for (int q = 0; q < std::min(queries, 20); q++)
+    {
+      float best = side, distance = side;
+
+      for (const Bvh::Bounds &bound : cubes.bounds)
+      {
+        best = std::min(best, slab(bound, origins[q], directions[q]));
+      }
+
+      int hit = bvh.raycast(origins[q], directions[q], distance);
+      mismatches += hit < 0 ? best < side : std::fabs(distance - best) > 1e-4f;
+    }
+
+    // Boxes the size of a few cubes around random points
+    size_t overlapping = 0;
+    std::vector<Bvh::Bounds> regions(queries);
+    for (Bvh::Bounds &region : regions)
+    {
+      glm::vec3 center(position(random), position(random), position(random));
+
+      region.min = center - glm::vec3(3.0f);
+      region.max = center + glm::vec3(3.0f);
+    }
+
+    double boxMs = time_ms([&] ()
+    {
+      for (const Bvh::Bounds &region : regions)
+      {
+        bvh.query(region, [&overlapping] (uint32_t) { overlapping++; });
+      }
+    });
+
+    for (const Bvh::Bounds &region : regions)
+    {
+      ids.clear();
+      bvh.query(region, [&ids] (uint32_t i) { ids.push_back(i); });
+      expectedIds.clear();
+      for (uint32_t i = 0; i < (uint32_t)count; i++)
+      {
+        if (region.overlaps(cubes.bounds[i]))
+        {
+          expectedIds.push_back(i);
+        }
+      }
+      mismatches += !same(ids, expectedIds);
+    }
+
+    std::cout << std::setw(7) << count
+              << std::setw(11) << serial << std::setw(15) << parallel
+              << std::setw(11) << refit
+              << std::setw(11) << built << " / " << std::setw(6) << refitted
+              << std::setw(12) << frustumMs * 1000.0 / queries << " (" << std::setw(8) << linearMs * 1000.0 / queries << ")"
+              << std::setw(9) << rayMs * 1000.0 / queries
+              << std::setw(9) << boxMs * 1000.0 / queries
+              << (mismatches ? "  MISMATCHES: " + std::to_string(mismatches) : "") << std::endl;
+    failures += mismatches;
+  }
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,695 @@
+// Frame-time benchmark of the example scenes.
+//
+// Runs each scene for a warm-up plus a number of measured frames and
+// prints, as JSON, the p50/p95/p99/max of the CPU frame time and of the
+// GPU time (GL_TIME_ELAPSED), plus the draw calls per frame. Vsync is off.
+//
+// Usage: bench [--frames=N] [--warmup=N] [--scene=NAME] [--output=FILE]
+//              [--headless ...]
+//
+// The scenes mirror 01-colors, 02b-basic-lighting, e12-moving-light,
+// 08-coordinate-systems and 06-textures, with the camera fixed at its
+// starting position. "cubes" draws a grid of Cube objects one by one
+// under an orbiting Camera, the CPU-heaviest scene; "cubes-culled" is the
+// same grid drawing only the cubes FrustumCuller finds in the frustum of
+// the camera, so the draw calls of the two can be compared. With
+// --headless (see Headless) it runs without a display, so the JSON can be
+// recorded for every commit.
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../../include/camera.h"
+#include "../../include/cube.h"
+#include "../../include/frame_stats.h"
+#include "../../include/frame_uniforms.h"
+#include "../../include/frustum_culler.h"
+#include "../../include/gl_state.h"
+#include "../../include/headless.h"
+#include "../../include/shader_s.h"
+
+#include "../../include/stb_image.h"
+
+const int SCR_HEIGHT = 600;
+const int SCR_WIDTH = 800;
+
+// Position, normal and texture coordinates of a unit cube
+const float CUBE_VERTICES[] = {
+  -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+   0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+   0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+   0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+  -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+  -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+  -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 0.0f,
+   0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 0.0f,
+   0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 1.0f,
+   0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 1.0f,
+  -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 1.0f,
+  -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 0.0f,
+
+  -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+  -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+  -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+  -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+  -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+  -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+   0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+   0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+   0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+   0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+   0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+   0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+  -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+   0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+   0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+   0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+  -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+  -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+  -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+   0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+   0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+   0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+  -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+  -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+};
+
+// Position, color and texture coordinates of the 06-textures quad
+const float QUAD_VERTICES[] = {
+  -0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,  0.0f, 0.0f,
+  -0.5f,  0.5f, 0.0f,  0.0f, 1.0f, 0.0f,  0.0f, 1.0f,
+   0.5f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f,  1.0f, 1.0f,
+   0.5f, -0.5f, 0.0f,  1.0f, 1.0f, 0.0f,  1.0f, 0.0f
+};
+const unsigned int QUAD_INDICES[] = {
+  0, 1, 3,
+  1, 2, 3
+};
+
+unsigned int drawCalls = 0;
+
+void draw_arrays (unsigned int VAO, GLsizei count)
+{
+  GLState::instance().bindVertexArray(VAO);
+  glDrawArrays(GL_TRIANGLES, 0, count);
+  drawCalls++;
+}
+
+void draw_elements (unsigned int VAO, GLsizei count)
+{
+  GLState::instance().bindVertexArray(VAO);
+  glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
+  drawCalls++;
+}
+
+struct Attribute
+{
+  GLuint location;
+  GLint components;
+  int offset;
+};
+
+// Makes a VAO over vertices of 8 floats; offsets are counted in floats
+unsigned int make_vao (unsigned int VBO, std::initializer_list<Attribute> attributes, unsigned int EBO = 0)
+{
+  unsigned int VAO;
+
+  glGenVertexArrays(1, &VAO);
+  GLState::instance().bindVertexArray(VAO);
+  GLState::instance().bindBuffer(GL_ARRAY_BUFFER, VBO);
+
+  for (const Attribute &attribute : attributes)
+  {
+    glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(attribute.offset * sizeof(float)));
+    glEnableVertexAttribArray(attribute.location);
+  }
+
+  if (EBO)
+  {
+    GLState::instance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+  }
+
+  GLState::instance().bindVertexArray(0);
+  return VAO;
+}
+
+unsigned int make_buffer (GLenum target, const void *data, size_t size)
+{
+  unsigned int buffer;
+
+  glGenBuffers(1, &buffer);
+  GLState::instance().bindBuffer(target, buffer);
+  glBufferData(target, size, data, GL_STATIC_DRAW);
+
+  return buffer;
+}
+
+unsigned int load_texture (const char *path)
+{
+  int width, height, channels;
+  unsigned int texture;
+
+  glGenTextures(1, &texture);
+  GLState::instance().bindTexture(0, GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  stbi_set_flip_vertically_on_load(true);
+  unsigned char *data = stbi_load(path, &width, &height, &channels, 0);
+  if (data)
+  {
+    GLenum format = channels == 4 ? GL_RGBA : GL_RGB;
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+  else
+  {
+    std::cout << "Error al cargar la textura " << path << std::endl;
+  }
+  stbi_image_free(data);
+
+  return texture;
+}
+
+/**
+ * @brief One scene: builds its GL objects, then draws one frame per call.
+ */
+class Scene
+{
+public:
+  Scene ()
+  {
+    camera.SetAspect((float)SCR_WIDTH / (float)SCR_HEIGHT);
+  }
+
+  virtual ~Scene () {}
+
+  virtual const char *name () const = 0;
+
+  virtual void render (float time) = 0;
+
+  virtual void clear () = 0;
+
+protected:
+  Camera camera = Camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+  const glm::mat4 &view ()
+  {
+    return camera.GetViewMatrix();
+  }
+
+  const glm::mat4 &projection ()
+  {
+    return camera.GetProjectionMatrix();
+  }
+};
+
+// 01-colors: lit cube and lamp, matrices uploaded to each program
+class ColorsScene : public Scene
+{
+public:
+  ColorsScene () :
+  objectShader("../shaders/textureless.vs.glsl", "../shaders/textureless.fs.glsl"),
+  lightShader("../shaders/textureless.vs.glsl", "../shaders/light.fs.glsl")
+  {
+    VBO = make_buffer(GL_ARRAY_BUFFER, CUBE_VERTICES, sizeof(CUBE_VERTICES));
+    VAO = make_vao(VBO, {{0, 3, 0}, {1, 3, 3}});
+
+    objectShader.use();
+    objectShader.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
+    objectShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+    objectShader.setVec3("lightPos", lightPos);
+  }
+
+  const char *name () const override
+  {
+    return "colors";
+  }
+
+  void render (float time) override
+  {
+    glm::mat4 lightModel = glm::scale(glm::translate(glm::mat4(1.0f), lightPos), glm::vec3(0.2f));
+
+    objectShader.use();
+    objectShader.setMat4("model", glm::mat4(1.0f));
+    objectShader.setMat4("view", view());
+    objectShader.setMat4("projection", projection());
+    objectShader.setVec3("viewPos", camera.Position);
+    draw_arrays(VAO, 36);
+
+    lightShader.use();
+    lightShader.setMat4("model", lightModel);
+    lightShader.setMat4("view", view());
+    lightShader.setMat4("projection", projection());
+    draw_arrays(VAO, 36);
+  }
+
+  void clear () override
+  {
+    objectShader.clear();
+    lightShader.clear();
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    GLState::instance().deleted(VAO);
+    GLState::instance().deleted(VBO);
+  }
+
+private:
+  Shader objectShader;
+  Shader lightShader;
+  unsigned int VAO, VBO;
+  glm::vec3 lightPos = glm::vec3(1.2f, 1.0f, 2.0f);
+};
+
+// 02b-basic-lighting and e12-moving-light: camera in the Frame block
+class LightingScene : public Scene
+{
+public:
+  LightingScene (const char *_name, const char *vertexPath, const char *fragmentPath, bool _movingLight) :
+  sceneName(_name),
+  movingLight(_movingLight),
+  objectShader(vertexPath, fragmentPath, FrameUniforms::DEFINE),
+  lightShader("../shaders/light.vs.glsl", "../shaders/light.fs.glsl", FrameUniforms::DEFINE)
+  {
+    VBO = make_buffer(GL_ARRAY_BUFFER, CUBE_VERTICES, sizeof(CUBE_VERTICES));
+    VAO = make_vao(VBO, {{0, 3, 0}, {1, 3, 3}});
+
+    objectShader.bindUniformBlock(FrameUniforms::BLOCK, FrameUniforms::BINDING);
+    lightShader.bindUniformBlock(FrameUniforms::BLOCK, FrameUniforms::BINDING);
+
+    objectShader.use();
+    objectShader.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
+    objectShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
+  }
+
+  const char *name () const override
+  {
+    return sceneName;
+  }
+
+  void render (float time) override
+  {
+    glm::vec3 lightPos = movingLight ? glm::vec3(sin(time), 1.0f, cos(time)) : glm::vec3(1.2f, 1.0f, 2.0f);
+    glm::mat4 lightModel = glm::scale(glm::translate(glm::mat4(1.0f), lightPos), glm::vec3(0.2f));
+
+    frame.update(view(), projection(), camera.Position, time, camera.GetVersion());
+
+    objectShader.use();
+    objectShader.setMat4("model", glm::mat4(1.0f));
+    objectShader.setVec3("lightPos", lightPos);
+    draw_arrays(VAO, 36);
+
+    lightShader.use();
+    lightShader.setMat4("model", lightModel);
+    draw_arrays(VAO, 36);
+  }
+
+  void clear () override
+  {
+    objectShader.clear();
+    lightShader.clear();
+    frame.clear();
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    GLState::instance().deleted(VAO);
+    GLState::instance().deleted(VBO);
+  }
+
+private:
+  const char *sceneName;
+  bool movingLight;
+  FrameUniforms frame;
+  Shader objectShader;
+  Shader lightShader;
+  unsigned int VAO, VBO;
+};
+
+// 08-coordinate-systems: ten textured cubes, one draw each
+class CoordinateSystemsScene : public Scene
+{
+public:
+  CoordinateSystemsScene () :
+  shader("../shaders/coord-system.vs.glsl", "../shaders/texture.fs.glsl")
+  {
+    VBO = make_buffer(GL_ARRAY_BUFFER, CUBE_VERTICES, sizeof(CUBE_VERTICES));
+    VAO = make_vao(VBO, {{0, 3, 0}, {1, 2, 6}});
+    textures[0] = load_texture("../../textures/container.jpg");
+    textures[1] = load_texture("../../textures/awesomeface.png");
+
+    shader.use();
+    shader.setInt("texture1", 0);
+    shader.setInt("texture2", 1);
+    shader.setMat4("view", glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f)));
+    shader.setMat4("projection", projection());
+  }
+
+  const char *name () const override
+  {
+    return "coordinate-systems";
+  }
+
+  void render (float time) override
+  {
+    const glm::vec3 positions[] = {
+      glm::vec3( 0.0f,  0.0f,   0.0f), glm::vec3( 2.0f,  5.0f, -15.0f),
+      glm::vec3(-1.5f, -2.2f,  -2.5f), glm::vec3(-3.8f, -2.0f, -12.3f),
+      glm::vec3( 2.4f, -0.4f,  -3.5f), glm::vec3(-1.7f,  3.0f,  -7.5f),
+      glm::vec3( 1.3f, -2.0f,  -2.5f), glm::vec3( 1.5f,  2.0f,  -2.5f),
+      glm::vec3( 1.5f,  0.2f,  -1.5f), glm::vec3(-1.3f,  1.0f,  -1.5f)
+    };
+
+    shader.use();
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D, textures[0]);
+    GLState::instance().bindTexture(1, GL_TEXTURE_2D, textures[1]);
+
+    for (unsigned int i = 0; i < 10; i++)
+    {
+      glm::mat4 model = glm::translate(glm::mat4(1.0f), positions[i]);
+      model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+      model = glm::rotate(model, time, glm::vec3(0.5f, 1.0f, 0.0f));
+
+      shader.setMat4("model", model);
+      draw_arrays(VAO, 36);
+    }
+  }
+
+  void clear () override
+  {
+    shader.clear();
+    glDeleteTextures(2, textures);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    for (unsigned int name : {textures[0], textures[1], VAO, VBO})
+    {
+      GLState::instance().deleted(name);
+    }
+  }
+
+private:
+  Shader shader;
+  unsigned int VAO, VBO;
+  unsigned int textures[2];
+};
+
+// 06-textures: one textured quad
+class TexturesScene : public Scene
+{
+public:
+  TexturesScene () :
+  shader("../shaders/texture.vs.glsl", "../shaders/texture.fs.glsl")
+  {
+    VBO = make_buffer(GL_ARRAY_BUFFER, QUAD_VERTICES, sizeof(QUAD_VERTICES));
+    EBO = make_buffer(GL_ELEMENT_ARRAY_BUFFER, QUAD_INDICES, sizeof(QUAD_INDICES));
+    VAO = make_vao(VBO, {{0, 3, 0}, {1, 3, 3}, {2, 2, 6}}, EBO);
+    textures[0] = load_texture("../../textures/container.jpg");
+    textures[1] = load_texture("../../textures/awesomeface.png");
+
+    shader.use();
+    shader.setInt("texture1", 0);
+    shader.setInt("texture2", 1);
+  }
+
+  const char *name () const override
+  {
+    return "textures";
+  }
+
+  void render (float time) override
+  {
+    shader.use();
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D, textures[0]);
+    GLState::instance().bindTexture(1, GL_TEXTURE_2D, textures[1]);
+    draw_elements(VAO, 6);
+  }
+
+  void clear () override
+  {
+    shader.clear();
+    glDeleteTextures(2, textures);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    for (unsigned int name : {textures[0], textures[1], VAO, VBO, EBO})
+    {
+      GLState::instance().deleted(name);
+    }
+  }
+
+private:
+  Shader shader;
+  unsigned int VAO, VBO, EBO;
+  unsigned int textures[2];
+};
+
+// Many objects: a grid of cubes, one model upload and draw each, seen by
+// a camera that turns every frame. With culled, the cubes outside its
+// frustum are skipped
+class CubesScene : public Scene
+{
+public:
+  static const int SIDE = 50;
+
+  CubesScene (bool _culled = false) :
+  shader("../shaders/cube-color.vs.glsl", "../shaders/cube-color.fs.glsl", FrameUniforms::DEFINE),
+  culled(_culled)
+  {
+    shader.bindUniformBlock(FrameUniforms::BLOCK, FrameUniforms::BINDING);
+    camera.Position = glm::vec3(0.0f, 10.0f, 40.0f);
+    camera.ProcessMouseMovement(0.0f, -150.0f);
+
+    // A unit cube turned any way fits in a box of half-size sqrt(3) / 2
+    glm::vec3 extents(0.87f);
+    for (int x = 0; x < SIDE; x++)
+    {
+      for (int z = 0; z < SIDE; z++)
+      {
+        glm::vec3 position((x - SIDE / 2) * 1.5f, 0.0f, (z - SIDE / 2) * 1.5f);
+        bounds.add(position - extents, position + extents);
+      }
+    }
+  }
+
+  const char *name () const override
+  {
+    return culled ? "cubes-culled" : "cubes";
+  }
+
+  void render (float time) override
+  {
+    camera.ProcessMouseMovement(2.0f, 0.0f);
+    frame.update(view(), projection(), camera.Position, time, camera.GetVersion());
+
+    if (culled)
+    {
+      FrustumCuller::cull(camera.GetFrustum(), bounds, visible);
+    }
+
+    shader.use();
+    for (int x = 0; x < SIDE; x++)
+    {
+      for (int z = 0; z < SIDE; z++)
+      {
+        if (culled && !visible[x * SIDE + z])
+        {
+          continue;
+        }
+
+        glm::vec3 position((x - SIDE / 2) * 1.5f, 0.0f, (z - SIDE / 2) * 1.5f);
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::rotate(model, time + 0.1f * (x + z), glm::vec3(0.5f, 1.0f, 0.0f));
+
+        shader.setMat4("model", model);
+        cube.draw();
+        drawCalls++;
+      }
+    }
+  }
+
+  void clear () override
+  {
+    shader.clear();
+    cube.clear();
+    frame.clear();
+  }
+
+private:
+  FrameUniforms frame;
+  Shader shader;
+  Cube cube;
+  bool culled;
+  FrustumCuller::Boxes bounds;
+  std::vector<uint8_t> visible;
+};
+
+std::unique_ptr<Scene> make_scene (const std::string &name)
+{
+  if (name == "colors")
+  {
+    return std::unique_ptr<Scene>(new ColorsScene());
+  }
+  if (name == "basic-lighting")
+  {
+    return std::unique_ptr<Scene>(new LightingScene("basic-lighting", "../shaders/textureless.vs.glsl", "../shaders/textureless.fs.glsl", false));
+  }
+  if (name == "moving-light")
+  {
+    return std::unique_ptr<Scene>(new LightingScene("moving-light", "../shaders/ej12.vs.glsl", "../shaders/ej12.fs.glsl", true));
+  }
+  if (name == "coordinate-systems")
+  {
+    return std::unique_ptr<Scene>(new CoordinateSystemsScene());
+  }
+  if (name == "textures")
+  {
+    return std::unique_ptr<Scene>(new TexturesScene());
+  }
+  if (name == "cubes")
+  {
+    return std::unique_ptr<Scene>(new CubesScene());
+  }
+  if (name == "cubes-culled")
+  {
+    return std::unique_ptr<Scene>(new CubesScene(true));
+  }
+  return nullptr;
+}
+
+int main (int argc, char **argv)
+{
+  const char *SCENES[] = {"colors", "basic-lighting", "moving-light", "coordinate-systems", "textures", "cubes", "cubes-culled"};
+  int frames = 500, warmup = 50;
+  std::string only, output;
+  GLFWwindow *window;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "--frames=", 9) == 0)
+    {
+      frames = atoi(argv[i] + 9);
+    }
+    else if (strncmp(argv[i], "--warmup=", 9) == 0)
+    {
+      warmup = atoi(argv[i] + 9);
+    }
+    else if (strncmp(argv[i], "--scene=", 8) == 0)
+    {
+      only = argv[i] + 8;
+    }
+    else if (strncmp(argv[i], "--output=", 9) == 0)
+    {
+      output = argv[i] + 9;
+    }
+  }
+
+  Headless::instance().init(argc, argv);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+  window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Bench", NULL, NULL);
+  if (window == NULL)
+  {
+    std::cout << "Error al crear la ventana" << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSwapInterval(0);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+  {
+    std::cout << "Error al cargar las funciones de OpenGL" << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  Headless::instance().attach(window);
+  glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+  glEnable(GL_DEPTH_TEST);
+
+  std::ostringstream json;
+  bool first = true;
+
+  json << "{\"renderer\": \"" << glGetString(GL_RENDERER) << "\", "
+       << "\"headless\": " << (Headless::instance().isEnabled() ? "true" : "false") << ", "
+       << "\"warmup\": " << warmup << ", \"scenes\": {";
+
+  for (const char *name : SCENES)
+  {
+    if (!only.empty() && only != name)
+    {
+      continue;
+    }
+
+    std::unique_ptr<Scene> scene = make_scene(name);
+    FrameStats stats(frames);
+
+    for (int frame = 0; frame < warmup + frames && !glfwWindowShouldClose(window); frame++)
+    {
+      bool measured = frame >= warmup;
+      float time = frame / 60.0f;
+
+      if (measured)
+      {
+        stats.beginFrame();
+      }
+
+      drawCalls = 0;
+      glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      scene->render(time);
+
+      if (measured)
+      {
+        stats.endRender(drawCalls);
+      }
+
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+
+      if (measured)
+      {
+        stats.endFrame();
+      }
+    }
+
+    stats.resolve();
+    json << (first ? "" : ", ") << "\"" << name << "\": " << stats.json();
+    first = false;
+
+    stats.clear();
+    scene->clear();
+  }
+
+  json << "}}";
+
+  if (output.empty())
+  {
+    std::cout << json.str() << std::endl;
+  }
+  else
+  {
+    std::ofstream(output) << json.str() << std::endl;
+    std::cout << "Results written to " << output << std::endl;
+  }
+
+  glfwTerminate();
+
+  return 0;
+}
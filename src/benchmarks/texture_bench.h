@@ -0,0 +1,115 @@
+#ifndef TEXTURE_BENCH_H
+#define TEXTURE_BENCH_H
+
+// Helpers shared by the texture benchmarks (b4-texture-loading,
+// b5-texture-cold-start): a hidden GL context, the list of images of a
+// directory, and the stb_image + glTexImage2D + glGenerateMipmap path
+// the examples use, which both benchmarks compare against.
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "../../include/gl_state.h"
+#include "../../include/headless.h"
+#include "../../include/stb_image.h"
+
+// A hidden window with a current GL 3.3 core context and vsync off, or
+// NULL (with GLFW terminated) if it could not be created
+inline GLFWwindow *create_context (int argc, char **argv, const char *title)
+{
+  GLFWwindow *window;
+
+  Headless::instance().init(argc, argv);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  window = glfwCreateWindow(64, 64, title, NULL, NULL);
+  if (window == NULL)
+  {
+    std::cout << "Error al crear la ventana" << std::endl;
+    glfwTerminate();
+    return NULL;
+  }
+  glfwMakeContextCurrent(window);
+  glfwSwapInterval(0);
+
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+  {
+    std::cout << "Error al cargar las funciones de OpenGL" << std::endl;
+    glfwTerminate();
+    return NULL;
+  }
+
+  return window;
+}
+
+// The .jpg/.png files of a directory
+inline std::vector<std::string> list_images (const std::string &directory)
+{
+  std::vector<std::string> paths;
+
+  for (const auto &entry : std::filesystem::directory_iterator(directory))
+  {
+    std::string extension = entry.path().extension().string();
+
+    if (extension == ".jpg" || extension == ".jpeg" || extension == ".png")
+    {
+      paths.push_back(entry.path().string());
+    }
+  }
+
+  return paths;
+}
+
+// Decodes and uploads every file on this thread, one after the other;
+// returns the milliseconds until glFinish()
+inline double load_stb (const std::vector<std::string> &paths, std::vector<unsigned int> &textures)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  for (const std::string &path : paths)
+  {
+    int width, height, channels;
+    unsigned int texture;
+
+    glGenTextures(1, &texture);
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    stbi_set_flip_vertically_on_load(true);
+    unsigned char *data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+    if (data)
+    {
+      GLenum format = channels == 4 ? GL_RGBA : GL_RGB;
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    stbi_image_free(data);
+
+    textures.push_back(texture);
+  }
+  glFinish();
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+inline void release (std::vector<unsigned int> &textures)
+{
+  glDeleteTextures((GLsizei)textures.size(), textures.data());
+  for (unsigned int texture : textures)
+  {
+    GLState::instance().deleted(texture);
+  }
+  textures.clear();
+}
+
+#endif
@@ -0,0 +1,3 @@
+// The stb_image implementation, compiled once into learngl_core
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
@@ -2,13 +2,14 @@
 #include <math.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <headless.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <shader_s.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <gl_state.h>
+#include <texture_loader.h>
 
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
 void process_input (GLFWwindow *window);
@@ -16,11 +17,10 @@ void process_input (GLFWwindow *window);
 const int WINDOW_HEIGHT = 600;
 const int WINDOW_WIDTH = 800;
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   // -------------------------------------------------------------------
-  int channels, height, width;
   int indices[] = {
     0, 1, 3,
     1, 2, 3
@@ -33,14 +33,13 @@ int main ()
      0.5f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f,  1.0f, 1.0f, // Sup der
      0.5f, -0.5f, 0.0f,  1.0f, 1.0f, 0.0f,  1.0f, 0.0f  // Inf der
   };
-  unsigned char *imageData;
   unsigned int texturas[2], transformLoc, EBO, VAO, VBO;
   glm::mat4 trans;
   GLFWwindow *window;
 
   // Inicialización
   // -------------------------------------------------------------------
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -61,6 +60,7 @@ int main ()
     std::cout << "Error al cargar las funciones de OpenGL" << std::endl;
     return -1;
   }
+  Headless::instance().attach(window);
 
   // Buffers
   // -------------------------------------------------------------------
@@ -89,43 +89,11 @@ int main ()
 
   // Texturas
   // -------------------------------------------------------------------
-  glGenTextures(2, texturas);
-  glBindTexture(GL_TEXTURE_2D, texturas[0]);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  imageData = stbi_load("../../textures/container.jpg", &width, &height, &channels, 0);
-  if (imageData)
-  {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, imageData);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  }
-  else
-  {
-    std::cout << "Error al cargar la textura 1" << std::endl;
-  }
-  stbi_image_free(imageData);
-
-  glBindTexture(GL_TEXTURE_2D, texturas[1]);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  stbi_set_flip_vertically_on_load(true);
-  imageData = stbi_load("../../textures/awesomeface.png", &width, &height, &channels, 0);
-  if (imageData)
-  {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  }
-  else
-  {
-    std::cout << "Error al cargar la textura 2" << std::endl;
-  }
-  stbi_image_free(imageData);
+  // Ambas imágenes se decodifican en paralelo, en otros hilos, mientras
+  // se prepara el resto; finish() las sube antes del primer cuadro
+  TextureLoader loader;
+  texturas[0] = loader.load("../../textures/container.jpg");
+  texturas[1] = loader.load("../../textures/awesomeface.png", true);
 
   // Shaders
   // -------------------------------------------------------------------
@@ -135,10 +103,10 @@ int main ()
   ourShader.setInt("texture1", 0);
   ourShader.setInt("texture2", 1);
 
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, texturas[0]);
-  glActiveTexture(GL_TEXTURE1);
-  glBindTexture(GL_TEXTURE_2D, texturas[1]);
+  loader.finish();
+
+  GLState::instance().bindTexture(0, GL_TEXTURE_2D, texturas[0]);
+  GLState::instance().bindTexture(1, GL_TEXTURE_2D, texturas[1]);
   transformLoc = glGetUniformLocation(ourShader.ID, "transform");
 
   // Ciclo de renderizado
@@ -168,6 +136,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
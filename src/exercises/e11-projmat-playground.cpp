@@ -1,13 +1,14 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <headless.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <shader_s.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <gl_state.h>
+#include <texture_loader.h>
 
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
 void process_input (GLFWwindow *window);
@@ -15,10 +16,9 @@ void process_input (GLFWwindow *window);
 const int WINDOW_HEIGHT = 600;
 const int WINDOW_WIDTH = 800;
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
-  int channels, height, width;
   int indices[] = {
     // TOP
     8, 10, 11, 
@@ -69,14 +69,13 @@ int main ()
      0.5f, -0.5f,  0.5f, 1.0f, 0.0f,   // 14
     -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,  // 15
   };
-  unsigned char *imageData;
   unsigned int textures[2];
   unsigned int matLocation, EBO, VAO, VBO;
   GLFWwindow *window;
   glm::mat4 model, view, projection;
 
   // Inicialización
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -97,6 +96,7 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
   glEnable(GL_DEPTH_TEST);
 
@@ -122,43 +122,11 @@ int main ()
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
   // Texturas
-  glGenTextures(2, textures);
-  glBindTexture(GL_TEXTURE_2D, textures[0]);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  imageData = stbi_load("../../textures/container.jpg", &width, &height, &channels, 0);
-  if (imageData)
-  {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, imageData);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  }
-  else
-  {
-    std::cout << "Error al cargar la textura 1" << std::endl;
-  }
-  stbi_image_free(imageData);
-
-  glBindTexture(GL_TEXTURE_2D, textures[1]);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  stbi_set_flip_vertically_on_load(true);
-  imageData = stbi_load("../../textures/awesomeface.png", &width, &height, &channels, 0);
-  if (imageData)
-  {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  }
-  else
-  {
-    std::cout << "Error al cargar la textura 2" << std::endl;
-  }
-  stbi_image_free(imageData);
+  // Ambas imágenes se decodifican en paralelo, en otros hilos, mientras
+  // se prepara el resto; finish() las sube antes del primer cuadro
+  TextureLoader loader;
+  textures[0] = loader.load("../../textures/container.jpg");
+  textures[1] = loader.load("../../textures/awesomeface.png", true);
 
   // Shaders
   Shader ourShader("../shaders/coord-system.vs.glsl", "../shaders/texture.fs.glsl");
@@ -179,16 +147,16 @@ int main ()
   matLocation = glGetUniformLocation(ourShader.ID, "model");
 
   // Ciclo de renderizado
+  loader.finish();
+
   while (!glfwWindowShouldClose(window))
   {
     process_input(window);
     glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textures[0]);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, textures[1]);
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D, textures[0]);
+    GLState::instance().bindTexture(1, GL_TEXTURE_2D, textures[1]);
 
     model = glm::mat4(1.0f);
     model = glm::rotate(model, (float)glfwGetTime(), glm::vec3(0.5f, 1.0f, 0.0f));
@@ -199,6 +167,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
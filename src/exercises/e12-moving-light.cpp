@@ -1,11 +1,14 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include "../../include/shader_s.h"
+#include "../../include/frame_uniforms.h"
+#include "../../include/gl_state.h"
+#include "../../include/shader_library.h"
 #include "../../include/camera.h"
 
 void click_callback (GLFWwindow *window, int button, int action, int mods);
@@ -25,10 +28,9 @@ float lastX;
 float lastY;
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
-  float aspect_ratio = (float)SCR_WIDTH / (float)SCR_HEIGHT;
   float currentFrame;
   float vertices[] = {
     -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,
@@ -76,10 +78,10 @@ int main ()
   unsigned int VAO[2], VBO;
   GLFWwindow *window;
   glm::vec3 lightPos;
-  glm::mat4 model, view, projection;
+  glm::mat4 model;
 
   // Inicialización
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -104,6 +106,7 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
   glEnable(GL_DEPTH_TEST);
 
@@ -127,13 +130,18 @@ int main ()
   glBindVertexArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-  // Shaders
-  Shader objectShader("../shaders/ej12.vs.glsl", "../shaders/ej12.fs.glsl");
-  Shader lightShader("../shaders/light.vs.glsl", "../shaders/light.fs.glsl");
+  // Shaders: both programs are read and compiled in parallel, the loop
+  // starts right away and draws with whatever is ready
+  ShaderLibrary library((GLADloadproc)glfwGetProcAddress);
+  ShaderHandle objectHandle = library.load("../shaders/ej12.vs.glsl", "../shaders/ej12.fs.glsl", FrameUniforms::DEFINE);
+  ShaderHandle lightHandle = library.load("../shaders/light.vs.glsl", "../shaders/light.fs.glsl", FrameUniforms::DEFINE);
+  bool objectInitialized = false;
+  bool lightInitialized = false;
 
-  objectShader.use();
-  objectShader.setVec3("objectColor", glm::vec3(1.0f, 0.5f, 0.31f));
-  objectShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+  // View, projection and camera position, written when the camera moves
+  // and read by both programs
+  FrameUniforms frame;
+  camera.SetAspect((float)SCR_WIDTH / (float)SCR_HEIGHT);
 
   // Ciclo de renderizado
   while (!glfwWindowShouldClose(window))
@@ -143,46 +151,75 @@ int main ()
     lastFrame = currentFrame;
 
     process_input(window);
+    library.update();
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Object rendering
     model = glm::mat4(1.0f);
-    view = camera.GetViewMatrix();
-    projection = glm::perspective(glm::radians(camera.Zoom), aspect_ratio, 0.1f, 100.0f);
+    frame.update(camera.GetViewMatrix(), camera.GetProjectionMatrix(), camera.Position, currentFrame, camera.GetVersion());
 
-    objectShader.use();
-    objectShader.setVec3("lightPos", lightPos);
-    objectShader.setVec3("viewPos", camera.Position);
-    objectShader.setMat4("model", model);
-    objectShader.setMat4("view", view);
-    objectShader.setMat4("projection", projection);
+    if (lightHandle.isReady() && !lightInitialized)
+    {
+      lightHandle.get().bindUniformBlock(FrameUniforms::BLOCK, FrameUniforms::BINDING);
+      lightInitialized = true;
+    }
+
+    if (objectHandle.isReady())
+    {
+      Shader &objectShader = objectHandle.get();
+      objectShader.use();
+
+      if (!objectInitialized)
+      {
+        objectShader.setVec3("objectColor", glm::vec3(1.0f, 0.5f, 0.31f));
+        objectShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+        objectShader.bindUniformBlock(FrameUniforms::BLOCK, FrameUniforms::BINDING);
+        objectInitialized = true;
+      }
+
+      objectShader.setVec3("lightPos", lightPos);
+      objectShader.setMat4("model", model);
+
+      GLState::instance().bindVertexArray(VAO[0]);
+      glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+    else if (lightHandle.isReady())
+    {
+      // Fallback: flat shaded object while the lighting program builds
+      Shader &fallbackShader = lightHandle.get();
+      fallbackShader.use();
+      fallbackShader.setMat4("model", model);
 
-    glBindVertexArray(VAO[0]);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+      GLState::instance().bindVertexArray(VAO[1]);
+      glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
 
     lightPos = glm::vec3(sin(currentFrame), 1.0f, cos(currentFrame));
     model = glm::mat4(1.0f);
     model = glm::translate(model, lightPos);
     model = glm::scale(model, glm::vec3(0.2f));
 
-    lightShader.use();    
-    lightShader.setMat4("model", model);
-    lightShader.setMat4("view", view);
-    lightShader.setMat4("projection", projection);
+    if (lightHandle.isReady())
+    {
+      Shader &lightShader = lightHandle.get();
+      lightShader.use();
+      lightShader.setMat4("model", model);
 
-    glBindVertexArray(VAO[1]);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+      GLState::instance().bindVertexArray(VAO[1]);
+      glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
+    GLState::instance().endFrame();
   }
 
   // Limpieza
-  lightShader.clear();
-  objectShader.clear();
+  GLState::instance().report();
+  library.clear();
+  frame.clear();
   glDeleteBuffers(1, &VBO);
   glDeleteVertexArrays(2, VAO);
   glfwTerminate();
@@ -202,6 +239,12 @@ void click_callback (GLFWwindow *window, int button, int action, int mods)
 void framebuffer_size_callback (GLFWwindow *window, int width, int height)
 {
   glViewport(0, 0, width, height);
+
+  // Minimizar la ventana la deja en 0x0
+  if (width > 0 && height > 0)
+  {
+    camera.SetAspect((float)width / (float)height);
+  }
 }
 
 void mouse_callback (GLFWwindow *window, double xPosIn, double yPosIn)
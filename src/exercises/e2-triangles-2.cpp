@@ -1,6 +1,7 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
 void process_input(GLFWwindow *window);
@@ -19,7 +20,7 @@ const char *vertexShaderSource = "#version 330 core\n"
   "  gl_Position = vec4(aPos.xyz, 1.0f);\n"
   "}\0";
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   char infoLog[512];
@@ -39,7 +40,7 @@ int main ()
   GLFWwindow *window;
 
   // Inicialización
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -59,6 +60,7 @@ int main ()
     glfwTerminate();
     return -1;
   }
+  Headless::instance().attach(window);
 
   glViewport(0, 0, 800, 600);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
@@ -143,6 +145,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
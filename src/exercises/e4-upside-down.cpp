@@ -1,12 +1,13 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 #include "../../include/shader_s.h"
 
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
 void process_input (GLFWwindow *window);
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   float vertex_data[] = {
@@ -19,7 +20,7 @@ int main ()
   GLFWwindow *window;
 
   // Inicialización
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -40,6 +41,7 @@ int main ()
     std::cout << "Error al cargar GLAD" << std::endl;
     return -1;
   }
+  Headless::instance().attach(window);
   
   // Crea y compila el shader program
   Shader ourShader("../shaders/ej4.vertex-shader.glsl", "../shaders/ej4.fragment-shader.glsl");
@@ -74,6 +76,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
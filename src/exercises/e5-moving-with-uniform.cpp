@@ -2,12 +2,13 @@
 #include <math.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 #include "../../include/shader_s.h"
 
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
 void process_input (GLFWwindow *window);
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   int timeValue;
@@ -22,7 +23,7 @@ int main ()
   GLFWwindow *window;
 
   // Inicialización
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -43,6 +44,7 @@ int main ()
     std::cout << "Error al cargar GLAD" << std::endl;
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, 800, 600);
   
   // Shaders
@@ -82,6 +84,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
@@ -1,9 +1,9 @@
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 #include "../../include/shader_s.h"
 
-#define STB_IMAGE_IMPLEMENTATION
 #include "../../include/stb_image.h"
 
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
@@ -12,7 +12,7 @@ void process_input (GLFWwindow *window);
 const int SCREEN_HEIGHT = 600;
 const int SCREEN_WIDTH = 800;
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   // -----------------------
@@ -35,7 +35,7 @@ int main ()
 
   // Inicialización
   // -----------------------
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -61,6 +61,7 @@ int main ()
     std::cout << "Error al cargar GLAD" << std::endl;
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 
 
@@ -147,6 +148,7 @@ int main ()
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
@@ -2,10 +2,11 @@
 #include <algorithm>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../../include/headless.h"
 #include "../../include/shader_s.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "../../include/stb_image.h"
+#include "../../include/gl_state.h"
+#include "../../include/texture_loader.h"
 
 void framebuffer_size_callback (GLFWwindow *window, int width, int height);
 void process_input (GLFWwindow *window, float *mixValue, float *alpha);
@@ -13,7 +14,7 @@ void process_input (GLFWwindow *window, float *mixValue, float *alpha);
 const int WINDOW_HEIGHT = 600;
 const int WINDOW_WIDTH = 800;
 
-int main ()
+int main (int argc, char **argv)
 {
   // Variables
   float alpha, mixValue;
@@ -27,14 +28,12 @@ int main ()
     0, 1, 3,
     1, 2, 3
   };
-  int channels, height, width;
-  unsigned char *imageData;  
   unsigned int EBO, texture, VAO, VBO;
   unsigned int textures[2];
   GLFWwindow *window;
 
   // Inicialización
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -54,6 +53,7 @@ int main ()
     std::cout << "Error al cargar las funciones de OpenGL" << std::endl;
     return -1;
   }
+  Headless::instance().attach(window);
   glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
 
   // Shaders
@@ -61,45 +61,11 @@ int main ()
   ourShader.use();
 
   // Texturas
-  glGenTextures(2, textures);
-  glBindTexture(GL_TEXTURE_2D, textures[0]);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  stbi_set_flip_vertically_on_load(true);
-  imageData = stbi_load("../../textures/container.jpg", &width, &height, &channels, 0);
-
-  if (imageData)
-  {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, imageData);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  }
-  else
-  {
-    std::cout << "Error al carga la textura 1" << std::endl;
-  }
-  stbi_image_free(imageData);
-
-  glBindTexture(GL_TEXTURE_2D, textures[1]);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  imageData = stbi_load("../../textures/awesomeface.png", &width, &height, &channels, 0);
-
-  if (imageData)
-  {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
-    glGenerateMipmap(GL_TEXTURE_2D);
-  }
-  else
-  {
-    std::cout << "Error al cargar la textura 2" << std::endl;
-  }
-  stbi_image_free(imageData);
+  // Ambas imágenes se decodifican en paralelo, en otros hilos, mientras
+  // se prepara el resto; finish() las sube antes del primer cuadro
+  TextureLoader loader;
+  textures[0] = loader.load("../../textures/container.jpg", true);
+  textures[1] = loader.load("../../textures/awesomeface.png", true);
 
   ourShader.setInt("texture1", 0);
   ourShader.setInt("texture2", 1);
@@ -131,6 +97,8 @@ int main ()
   // Ciclo de renderizado
   alpha = 0.0f;
   mixValue = 0.2f;
+  loader.finish();
+
   while (!glfwWindowShouldClose(window))
   {
     process_input(window, &mixValue, &alpha);
@@ -139,16 +107,15 @@ int main ()
 
     ourShader.setFloat("mixValue", mixValue);
     ourShader.setFloat("alpha", alpha);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textures[0]);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, textures[1]);
+    GLState::instance().bindTexture(0, GL_TEXTURE_2D, textures[0]);
+    GLState::instance().bindTexture(1, GL_TEXTURE_2D, textures[1]);
 
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
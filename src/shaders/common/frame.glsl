@@ -0,0 +1,21 @@
+// Per-frame values shared by every program: camera matrices, camera
+// position and time.
+//
+// Permutation defines:
+//   FRAME_UNIFORMS  reads them from the "Frame" uniform block, written
+//                   once per frame (see FrameUniforms); otherwise they are
+//                   plain uniforms set on each program
+#ifdef FRAME_UNIFORMS
+layout (std140) uniform Frame
+{
+  mat4 view;
+  mat4 projection;
+  vec3 viewPos;
+  float time;
+};
+#else
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+uniform float time;
+#endif
@@ -0,0 +1,33 @@
+// Ambient + diffuse + specular light of a single point light.
+//
+// Permutation defines:
+//   SPECULAR  0 drops the specular term (default 1)
+#ifndef SPECULAR
+#define SPECULAR 1
+#endif
+
+vec3 phong (vec3 normal, vec3 fragPos, vec3 lightPos, vec3 viewPos, vec3 lightColor, float shininess)
+{
+  // Ambient light
+  float ambientStrength = 0.1f;
+  vec3 ambientLight = ambientStrength * lightColor;
+
+  // Diffuse light
+  vec3 norm = normalize(normal);
+  vec3 lightDir = normalize(lightPos - fragPos);
+  float diff = max(dot(norm, lightDir), 0.0);
+  vec3 diffuseLight = diff * lightColor;
+
+#if SPECULAR
+  // Specular light
+  float specularStrength = 0.5;
+  vec3 viewDir = normalize(viewPos - fragPos);
+  vec3 reflectDir = reflect(-lightDir, norm);
+  float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+  vec3 specularLight = specularStrength * spec * lightColor;
+
+  return ambientLight + diffuseLight + specularLight;
+#else
+  return ambientLight + diffuseLight;
+#endif
+}
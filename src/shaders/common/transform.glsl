@@ -0,0 +1,14 @@
+// Model, view and projection transform shared by the vertex shaders.
+#include "frame.glsl"
+
+uniform mat4 model;
+
+vec4 clip_position (vec3 position)
+{
+  return projection * view * model * vec4(position, 1.0f);
+}
+
+vec3 world_position (vec3 position)
+{
+  return vec3(model * vec4(position, 1.0f));
+}
@@ -0,0 +1,25 @@
+#version 330 core
+#include "common/frame.glsl"
+
+layout (location = 0) in vec3 aPos;
+
+// Permutation defines:
+//   INSTANCED  reads the model matrix from the per-instance attribute at
+//              locations 3-6 (see CubeInstances) instead of a uniform
+#ifdef INSTANCED
+layout (location = 3) in mat4 aModel;
+#define MODEL aModel
+#else
+uniform mat4 model;
+#define MODEL model
+#endif
+
+out vec3 Color;
+
+void main ()
+{
+  gl_Position = projection * view * MODEL * vec4(aPos, 1.0f);
+
+  // Tint each cube by its position, so neighbours can be told apart
+  Color = 0.5f + 0.5f * sin(MODEL[3].xyz);
+}
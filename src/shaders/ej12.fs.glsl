@@ -1,33 +1,36 @@
 #version 330 core
+#include "common/frame.glsl"
+#include "common/phong.glsl"
+
+// Permutation defines:
+//   SHININESS  specular exponent (default 32.0)
+//   TEXTURED   modulates objectColor with diffuseMap
+#ifndef SHININESS
+#define SHININESS 32.0
+#endif
 
 in vec3 FragPos;
 in vec3 Normal;
 
+#ifdef TEXTURED
+in vec2 TexCoord;
+uniform sampler2D diffuseMap;
+#endif
+
 out vec4 FragColor;
 
 uniform vec3 lightPos;
 uniform vec3 lightColor;
 uniform vec3 objectColor;
-uniform vec3 viewPos;
 
 void main ()
 {
-  // Ambient light
-  float ambientStrength = 0.1f;
-  vec3 ambientLight = lightColor * ambientStrength;
-
-  // Diffuse light
-  vec3 norm = normalize(Normal);
-  vec3 lightDir = normalize(lightPos - FragPos);
-  float diff = max(dot(norm, lightDir), 0.0);
-  vec3 diffuseLight = diff * lightColor;
-
-  float specularStrength = 0.5;
-  vec3 viewDir = normalize(viewPos - FragPos);
-  vec3 reflectDir = reflect(-lightDir, norm);
-  float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-  vec3 specularLight = specularStrength * spec * lightColor;
+#ifdef TEXTURED
+  vec3 surfaceColor = objectColor * texture(diffuseMap, TexCoord).rgb;
+#else
+  vec3 surfaceColor = objectColor;
+#endif
 
-  vec3 result = (ambientLight + diffuseLight + specularLight) * objectColor;
+  vec3 result = phong(Normal, FragPos, lightPos, viewPos, lightColor, SHININESS) * surfaceColor;
   FragColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
@@ -1,12 +1,9 @@
 #version 330 core
+#include "common/transform.glsl"
 
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
 void main ()
 {
-  gl_Position = projection * view * model * vec4(aPos, 1.0f);
-}
\ No newline at end of file
+  gl_Position = clip_position(aPos);
+}
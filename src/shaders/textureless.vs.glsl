@@ -1,17 +1,25 @@
 #version 330 core
+#include "common/transform.glsl"
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 
+// Permutation defines:
+//   TEXTURED  passes aTexCoord (location 2) through to the fragment shader
+#ifdef TEXTURED
+layout (location = 2) in vec2 aTexCoord;
+out vec2 TexCoord;
+#endif
+
 out vec3 Normal;
 out vec3 FragPos;
 
-uniform mat4 model;
-uniform mat4 projection;
-uniform mat4 view;
-
 void main ()
 {
-  gl_Position = projection * view * model * vec4(aPos, 1.0f);
-  FragPos = vec3(model *vec4(aPos, 1.0f));
+  gl_Position = clip_position(aPos);
+  FragPos = world_position(aPos);
   Normal = aNormal;
-}
\ No newline at end of file
+#ifdef TEXTURED
+  TexCoord = aTexCoord;
+#endif
+}
@@ -1,11 +1,12 @@
 #include <glad/glad.h>
 #include <iostream>
 #include <GLFW/glfw3.h>
+#include "../include/headless.h"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 
-int main ()
+int main (int argc, char **argv)
 {
   float vertices[] = {
     -0.5f, -0.5f, 0.0f,
@@ -13,7 +14,7 @@ int main ()
      0.0f,  0.5f, 0.0f
   };
 
-  glfwInit();
+  Headless::instance().init(argc, argv);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -31,6 +32,7 @@ int main ()
   {
     std::cout << "Failed to initialize GLAD" << std::endl;
   }
+  Headless::instance().attach(window);
 
   glViewport(0, 0, 800, 600);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
@@ -42,6 +44,7 @@ int main ()
 
     processInput(window);
     glfwSwapBuffers(window);
+    Headless::instance().frame(window);
     glfwPollEvents();
   }
 
@@ -0,0 +1,98 @@
+// Texture cooker: converts images (anything stb_image reads) into the
+// .lgtx files of TextureFile, with their mip chain, so the examples can
+// map them instead of decoding them on every run.
+//
+// Usage: texcook [--flip] [--no-mipmaps] [--compress=FORMAT]
+//                [--out=DIRECTORY] IMAGE...
+//
+// --flip flips the images vertically, like
+// stbi_set_flip_vertically_on_load(true) does at runtime. FORMAT is bc1,
+// bc3, bc7 or auto (BC7 for images with alpha, BC1 for the rest); by
+// default the levels are stored uncompressed. Each IMAGE is written next
+// to itself (or into DIRECTORY) with the .lgtx extension, e.g.
+// textures/container.jpg -> textures/container.lgtx.
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../include/texture_file.h"
+#include "../../include/thread_pool.h"
+
+int main (int argc, char **argv)
+{
+  bool flip = false, mipmaps = true;
+  std::string directory, compress = "none";
+  std::vector<std::string> images;
+  int failed = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--flip") == 0)
+    {
+      flip = true;
+    }
+    else if (strcmp(argv[i], "--no-mipmaps") == 0)
+    {
+      mipmaps = false;
+    }
+    else if (strncmp(argv[i], "--compress=", 11) == 0)
+    {
+      compress = argv[i] + 11;
+    }
+    else if (strncmp(argv[i], "--out=", 6) == 0)
+    {
+      directory = argv[i] + 6;
+    }
+    else
+    {
+      images.push_back(argv[i]);
+    }
+  }
+
+  if (images.empty() || (compress != "none" && compress != "bc1" && compress != "bc3" && compress != "bc7" && compress != "auto"))
+  {
+    std::cout << "Usage: texcook [--flip] [--no-mipmaps] [--compress=bc1|bc3|bc7|auto] [--out=DIRECTORY] IMAGE..." << std::endl;
+    return -1;
+  }
+
+  ThreadPool pool;
+
+  for (const std::string &image : images)
+  {
+    std::filesystem::path output = std::filesystem::path(image).replace_extension(".lgtx");
+
+    if (!directory.empty())
+    {
+      output = std::filesystem::path(directory) / output.filename();
+    }
+
+    BlockCompression::Format format = BlockCompression::NONE;
+    int width, height, channels = 0;
+
+    if (compress == "bc1" || (compress == "auto" && stbi_info(image.c_str(), &width, &height, &channels) && channels % 2 == 1))
+    {
+      format = BlockCompression::BC1;
+    }
+    else if (compress == "bc3")
+    {
+      format = BlockCompression::BC3;
+    }
+    else if (compress == "bc7" || compress == "auto")
+    {
+      format = BlockCompression::BC7;
+    }
+
+    if (TextureFile::cook(image, output.string(), flip, mipmaps, format, &pool))
+    {
+      std::cout << image << " -> " << output.string() << " (" << std::filesystem::file_size(output) << " bytes)" << std::endl;
+    }
+    else
+    {
+      failed++;
+    }
+  }
+
+  return failed == 0 ? 0 : -1;
+}